@@ -0,0 +1,120 @@
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+#include <Arduino.h>
+#include "relay_config.h"
+
+// Compile-time pin access.
+// digitalWrite()/digitalRead() look the pin up in PROGMEM tables, check for
+// PWM and save/restore SREG on every call. With the pin number as a template
+// argument the port and bit are constants, so each access can compile to a
+// single sbi/cbi/sbic instruction, which is also atomic and therefore safe
+// from ISRs. The flash and cycle savings have not been measured yet (see
+// README.md).
+//
+// ATmega328P (Nano) pin map: D0-D7 = PORTD, D8-D13 = PORTB, A0-A5 = PORTC.
+// A6/A7 are ADC-only and have no digital port.
+//
+// On the host build the calls go through the simulated pins, so pin hooks
+// and the input simulation behave exactly as before.
+
+enum FastPinPort : uint8_t { FASTPIN_PORT_B, FASTPIN_PORT_C, FASTPIN_PORT_D };
+
+constexpr FastPinPort fastPinPort(uint8_t pin) {
+  return pin < 8 ? FASTPIN_PORT_D : (pin < 14 ? FASTPIN_PORT_B : FASTPIN_PORT_C);
+}
+
+constexpr uint8_t fastPinMask(uint8_t pin) {
+  return 1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+}
+
+template <uint8_t Pin>
+struct FastPin {
+  static_assert(Pin < 20, "Pin has no digital port (A6/A7 are analog-only)");
+
+  static constexpr uint8_t pin = Pin;
+  static constexpr FastPinPort port = fastPinPort(Pin);
+  static constexpr uint8_t mask = fastPinMask(Pin);
+
+#if defined(__AVR__)
+  // The branches fold away: only one port is ever referenced per pin
+  static inline void high() {
+    if (Pin < 8) PORTD |= mask;
+    else if (Pin < 14) PORTB |= mask;
+    else PORTC |= mask;
+  }
+
+  static inline void low() {
+    if (Pin < 8) PORTD &= ~mask;
+    else if (Pin < 14) PORTB &= ~mask;
+    else PORTC &= ~mask;
+  }
+
+  static inline bool read() {
+    if (Pin < 8) return (PIND & mask) != 0;
+    if (Pin < 14) return (PINB & mask) != 0;
+    return (PINC & mask) != 0;
+  }
+
+  static inline void output() {
+    if (Pin < 8) DDRD |= mask;
+    else if (Pin < 14) DDRB |= mask;
+    else DDRC |= mask;
+  }
+
+  static inline void input() {
+    // DDR bit clear; the PORT bit selects the internal pull-up
+    if (Pin < 8) DDRD &= ~mask;
+    else if (Pin < 14) DDRB &= ~mask;
+    else DDRC &= ~mask;
+    low();
+  }
+
+  static inline void inputPullup() {
+    if (Pin < 8) DDRD &= ~mask;
+    else if (Pin < 14) DDRB &= ~mask;
+    else DDRC &= ~mask;
+    high();
+  }
+#else
+  static inline void high() { digitalWrite(Pin, HIGH); }
+  static inline void low() { digitalWrite(Pin, LOW); }
+  static inline bool read() { return digitalRead(Pin) == HIGH; }
+  static inline void output() { pinMode(Pin, OUTPUT); }
+  static inline void input() { pinMode(Pin, INPUT); }
+  static inline void inputPullup() { pinMode(Pin, INPUT_PULLUP); }
+#endif
+
+  static inline void write(bool level) {
+    if (level) {
+      high();
+    } else {
+      low();
+    }
+  }
+};
+
+// Relay or MOSFET driver output. The RELAY_ON/RELAY_OFF levels from
+// relay_config.h are folded in at compile time.
+template <uint8_t Pin>
+struct RelayPin : FastPin<Pin> {
+  static inline void on() { FastPin<Pin>::write(RELAY_ON == HIGH); }
+  static inline void off() { FastPin<Pin>::write(RELAY_OFF == HIGH); }
+  static inline void set(bool active) {
+    if (active) {
+      on();
+    } else {
+      off();
+    }
+  }
+  static inline bool isOn() { return FastPin<Pin>::read() == (RELAY_ON == HIGH); }
+
+  // Output starting in the OFF state: the level is latched before the pin
+  // becomes an output, so the relay never clicks at boot
+  static inline void setup() {
+    off();
+    FastPin<Pin>::output();
+  }
+};
+
+#endif // FASTPIN_H
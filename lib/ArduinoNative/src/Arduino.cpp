@@ -0,0 +1,180 @@
+#include "Arduino.h"
+#include "sim.h"
+
+// A blocking analogRead() on a 16 MHz ATmega328 with the default /128
+// prescaler takes 13 ADC clocks = 104 us plus call overhead.
+static const uint32_t ANALOG_READ_MICROS = 112;
+
+static uint64_t clockMicros = 0;
+
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static uint8_t pinInputLevels[NUM_DIGITAL_PINS];
+static uint8_t pinOutputLevels[NUM_DIGITAL_PINS];
+static int analogValues[NUM_ANALOG_INPUTS];
+static unsigned long analogReadCount = 0;
+
+struct ExternalInterrupt {
+  void (*handler)(void);
+  int mode;
+};
+static ExternalInterrupt externalInterrupts[2];
+static void (*pinChangeHandlers[NUM_DIGITAL_PINS])(void);
+
+static SimPinWriteHook pinWriteHook = nullptr;
+static void* pinWriteHookCtx = nullptr;
+
+uint64_t simMicros() {
+  return clockMicros;
+}
+
+void simAdvanceMicros(uint64_t us) {
+  clockMicros += us;
+}
+
+void simAdvanceMillis(unsigned long ms) {
+  clockMicros += (uint64_t)ms * 1000;
+}
+
+unsigned long millis() {
+  return (unsigned long)(clockMicros / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)clockMicros;
+}
+
+void delay(unsigned long ms) {
+  simAdvanceMillis(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvanceMicros(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NUM_DIGITAL_PINS) return;
+  pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= NUM_DIGITAL_PINS) return;
+  pinOutputLevels[pin] = val ? HIGH : LOW;
+  if (pinWriteHook) pinWriteHook(pin, pinOutputLevels[pin], pinWriteHookCtx);
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= NUM_DIGITAL_PINS) return LOW;
+  if (pinModes[pin] == OUTPUT) return pinOutputLevels[pin];
+  return pinInputLevels[pin];
+}
+
+static int analogChannel(uint8_t pin) {
+  if (pin >= A0) pin -= A0;
+  return pin < NUM_ANALOG_INPUTS ? pin : -1;
+}
+
+int analogRead(uint8_t pin) {
+  int channel = analogChannel(pin);
+  simAdvanceMicros(ANALOG_READ_MICROS);
+  analogReadCount++;
+  return channel < 0 ? 0 : analogValues[channel];
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*handler)(void), int mode) {
+  if (interruptNum >= 2) return;
+  externalInterrupts[interruptNum].handler = handler;
+  externalInterrupts[interruptNum].mode = mode;
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+  if (interruptNum >= 2) return;
+  externalInterrupts[interruptNum].handler = nullptr;
+}
+
+void attachPinChangeInterrupt(uint8_t pin, void (*handler)(void)) {
+  if (pin >= NUM_DIGITAL_PINS) return;
+  pinChangeHandlers[pin] = handler;
+}
+
+static void dispatchPinInterrupts(uint8_t pin, uint8_t previous, uint8_t level) {
+  if (level != previous && pinChangeHandlers[pin] != nullptr) {
+    pinChangeHandlers[pin]();
+  }
+
+  int interruptNum = digitalPinToInterrupt(pin);
+  if (interruptNum == NOT_AN_INTERRUPT) return;
+  ExternalInterrupt& irq = externalInterrupts[interruptNum];
+  if (irq.handler == nullptr) return;
+
+  bool fire = false;
+  switch (irq.mode) {
+    case LOW:     fire = (level == LOW); break;
+    case CHANGE:  fire = (level != previous); break;
+    case FALLING: fire = (previous == HIGH && level == LOW); break;
+    case RISING:  fire = (previous == LOW && level == HIGH); break;
+  }
+  if (fire) irq.handler();
+}
+
+void simSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= NUM_DIGITAL_PINS) return;
+  uint8_t previous = pinInputLevels[pin];
+  pinInputLevels[pin] = level ? HIGH : LOW;
+  if (pinInputLevels[pin] != previous || level == LOW) {
+    dispatchPinInterrupts(pin, previous, pinInputLevels[pin]);
+  }
+}
+
+uint8_t simGetPin(uint8_t pin) {
+  if (pin >= NUM_DIGITAL_PINS) return LOW;
+  return pinModes[pin] == OUTPUT ? pinOutputLevels[pin] : pinInputLevels[pin];
+}
+
+uint8_t simGetPinMode(uint8_t pin) {
+  return pin < NUM_DIGITAL_PINS ? pinModes[pin] : INPUT;
+}
+
+void simOnPinWrite(SimPinWriteHook hook, void* ctx) {
+  pinWriteHook = hook;
+  pinWriteHookCtx = ctx;
+}
+
+void simSetAnalog(uint8_t pin, int value) {
+  int channel = analogChannel(pin);
+  if (channel < 0) return;
+  analogValues[channel] = constrain(value, 0, 1023);
+}
+
+int simGetAnalog(uint8_t pin) {
+  int channel = analogChannel(pin);
+  return channel < 0 ? 0 : analogValues[channel];
+}
+
+unsigned long simAnalogReads() {
+  return analogReadCount;
+}
+
+SimUart& simSerialPort() {
+  // HardwareSerial: 64-byte RX and TX ring buffers
+  static SimUart port(64, 64);
+  return port;
+}
+
+SimUart& simGpsPort() {
+  // SoftwareSerial: 64-byte RX buffer, unbuffered TX
+  static SimUart port(64, 0);
+  return port;
+}
+
+void simReset() {
+  clockMicros = 0;
+  memset(pinModes, INPUT, sizeof(pinModes));
+  memset(pinInputLevels, LOW, sizeof(pinInputLevels));
+  memset(pinOutputLevels, LOW, sizeof(pinOutputLevels));
+  memset(analogValues, 0, sizeof(analogValues));
+  memset(externalInterrupts, 0, sizeof(externalInterrupts));
+  memset(pinChangeHandlers, 0, sizeof(pinChangeHandlers));
+  analogReadCount = 0;
+  simSerialPort().reset();
+  simGpsPort().reset();
+}
@@ -0,0 +1,83 @@
+#ifndef ARDUINO_NATIVE_H
+#define ARDUINO_NATIVE_H
+
+// Host implementation of the subset of the Arduino API used by the firmware.
+// Pins, ADC channels and UARTs are simulated (see sim.h) and time comes from
+// a virtual clock, so setup()/loop() run deterministically on a desktop.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "avr/pgmspace.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define PI         3.1415926535897932384626433832795
+#define HALF_PI    1.5707963267948966192313216916398
+#define TWO_PI     6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ATmega328 (Nano) pin map: D0-D13, then A0-A7
+#define NUM_DIGITAL_PINS 22
+#define NUM_ANALOG_INPUTS 8
+static const uint8_t A0 = 14;
+static const uint8_t A1 = 15;
+static const uint8_t A2 = 16;
+static const uint8_t A3 = 17;
+static const uint8_t A4 = 18;
+static const uint8_t A5 = 19;
+static const uint8_t A6 = 20;
+static const uint8_t A7 = 21;
+static const uint8_t LED_BUILTIN = 13;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// External interrupts: INT0 on D2, INT1 on D3. Handlers run synchronously
+// from simSetPin() when the level change matches the trigger mode.
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+void attachInterrupt(uint8_t interruptNum, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+// Pin change interrupts (PCINT) have no Arduino API; on the AVR the firmware
+// programs PCICR/PCMSKx directly. On the host it registers the handler here
+// and simSetPin() calls it on every level change of that pin.
+void attachPinChangeInterrupt(uint8_t pin, void (*handler)(void));
+
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+void setup();
+void loop();
+
+#endif
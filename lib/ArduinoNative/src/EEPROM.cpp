@@ -0,0 +1,61 @@
+#include "EEPROM.h"
+#include "sim.h"
+
+EEPROMClass EEPROM;
+
+static const uint16_t EEPROM_SIZE = 1024;
+static const uint64_t EEPROM_WRITE_MICROS = 3300;   // One byte write on the ATmega328
+
+static uint8_t* eepromBytes() {
+  static uint8_t bytes[EEPROM_SIZE];
+  static bool erased = false;
+  if (!erased) {
+    memset(bytes, 0xFF, sizeof(bytes));
+    erased = true;
+  }
+  return bytes;
+}
+
+static unsigned long eepromWriteCount = 0;
+static uint64_t eepromBusyUntil = 0;
+
+bool eeprom_is_ready() {
+  uint64_t now = simMicros();
+  // Also ready after simReset() moved the clock back to zero
+  return now >= eepromBusyUntil || eepromBusyUntil - now > EEPROM_WRITE_MICROS;
+}
+
+uint8_t EEPROMClass::read(int address) {
+  if (address < 0 || address >= EEPROM_SIZE) return 0xFF;
+  return eepromBytes()[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address < 0 || address >= EEPROM_SIZE) return;
+  // A byte write takes 3.3 ms on the ATmega328. The CPU only spins when it
+  // starts a write before the previous one is done.
+  if (!eeprom_is_ready()) simAdvanceMicros(eepromBusyUntil - simMicros());
+  eepromBusyUntil = simMicros() + EEPROM_WRITE_MICROS;
+  eepromWriteCount++;
+  eepromBytes()[address] = value;
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  if (read(address) != value) write(address, value);
+}
+
+uint16_t EEPROMClass::length() {
+  return EEPROM_SIZE;
+}
+
+uint8_t* simEepromData() {
+  return eepromBytes();
+}
+
+size_t simEepromSize() {
+  return EEPROM_SIZE;
+}
+
+unsigned long simEepromWrites() {
+  return eepromWriteCount;
+}
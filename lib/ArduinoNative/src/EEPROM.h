@@ -0,0 +1,34 @@
+#ifndef ARDUINO_NATIVE_EEPROM_H
+#define ARDUINO_NATIVE_EEPROM_H
+
+// Host implementation of the AVR EEPROM library (1 KB on the ATmega328).
+// Contents start erased (0xFF) and survive simReset(), like a power cycle;
+// hosts can preload or save them through simEepromData().
+
+#include <stdint.h>
+#include <string.h>
+#include "avr/eeprom.h"
+
+class EEPROMClass {
+public:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length();
+
+  template <typename T> T& get(int address, T& value) {
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(T); i++) bytes[i] = read(address + (int)i);
+    return value;
+  }
+
+  template <typename T> const T& put(int address, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(T); i++) update(address + (int)i, bytes[i]);
+    return value;
+  }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,13 @@
+#include "HardwareSerial.h"
+#include "SimUart.h"
+#include "sim.h"
+
+HardwareSerial Serial(simSerialPort());
+
+void HardwareSerial::begin(unsigned long baud) { port.begin(baud); }
+int HardwareSerial::available() { return port.available(); }
+int HardwareSerial::read() { return port.read(); }
+int HardwareSerial::peek() { return port.peek(); }
+void HardwareSerial::flush() { port.flush(); }
+size_t HardwareSerial::write(uint8_t c) { return port.write(c); }
+int HardwareSerial::availableForWrite() { return port.availableForWrite(); }
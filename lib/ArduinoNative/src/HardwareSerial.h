@@ -0,0 +1,30 @@
+#ifndef ARDUINO_NATIVE_HARDWARE_SERIAL_H
+#define ARDUINO_NATIVE_HARDWARE_SERIAL_H
+
+#include "Stream.h"
+
+class SimUart;
+
+// Hardware UART (D0/D1, the ESP32 link) backed by a simulated port
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(SimUart& port) : port(port) {}
+
+  void begin(unsigned long baud);
+  void end() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush();
+  size_t write(uint8_t c) override;
+  using Print::write;
+  int availableForWrite() override;
+  operator bool() { return true; }
+
+private:
+  SimUart& port;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,144 @@
+#include "SimUart.h"
+#include "sim.h"
+
+#include <string.h>
+
+SimUart::SimUart(size_t rxCapacity, size_t txCapacity)
+  : rxCap(rxCapacity), txCap(txCapacity), baudRate(0), txSink(nullptr), txSinkCtx(nullptr) {
+  reset();
+}
+
+void SimUart::reset() {
+  pending.clear();
+  rx.clear();
+  nextArrival = 0;
+  txQueued = 0;
+  txLastDrain = 0;
+  rxDelivered = 0;
+  rxOverflows = 0;
+  txBytes = 0;
+  txBlockedMicros = 0;
+}
+
+void SimUart::configure(size_t rxCapacity, size_t txCapacity) {
+  rxCap = rxCapacity;
+  txCap = txCapacity;
+  rx.clear();
+  txQueued = 0;
+}
+
+void SimUart::begin(unsigned long baud) {
+  baudRate = baud;
+  txLastDrain = simMicros();
+}
+
+uint32_t SimUart::byteTimeMicros() const {
+  // 8N1 framing: start + 8 data + stop bits
+  return baudRate ? (uint32_t)((10UL * 1000000UL + baudRate - 1) / baudRate) : 0;
+}
+
+void SimUart::inject(const uint8_t* data, size_t len) {
+  if (pending.empty() && nextArrival < simMicros()) {
+    nextArrival = simMicros();
+  }
+  pending.insert(pending.end(), data, data + len);
+}
+
+void SimUart::inject(const char* str) {
+  inject(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+void SimUart::setTxSink(TxSink sink, void* ctx) {
+  txSink = sink;
+  txSinkCtx = ctx;
+}
+
+void SimUart::pump() {
+  uint64_t now = simMicros();
+  uint32_t byteTime = byteTimeMicros();
+
+  // Deliver bytes that have finished arriving on the wire
+  while (!pending.empty() && nextArrival + byteTime <= now) {
+    if (rx.size() < rxCap) {
+      rx.push_back(pending.front());
+      rxDelivered++;
+    } else {
+      rxOverflows++;
+    }
+    pending.pop_front();
+    nextArrival += byteTime;
+  }
+
+  // Drain the transmit buffer at line rate
+  if (txQueued == 0 || byteTime == 0) {
+    txQueued = 0;
+    txLastDrain = now;
+    return;
+  }
+  uint64_t drained = (now - txLastDrain) / byteTime;
+  if (drained >= txQueued) {
+    txQueued = 0;
+    txLastDrain = now;
+  } else {
+    txQueued -= (size_t)drained;
+    txLastDrain += drained * byteTime;
+  }
+}
+
+int SimUart::available() {
+  pump();
+  return (int)rx.size();
+}
+
+int SimUart::read() {
+  pump();
+  if (rx.empty()) return -1;
+  uint8_t c = rx.front();
+  rx.pop_front();
+  return c;
+}
+
+int SimUart::peek() {
+  pump();
+  return rx.empty() ? -1 : rx.front();
+}
+
+size_t SimUart::write(uint8_t c) {
+  pump();
+  uint32_t byteTime = byteTimeMicros();
+  if (byteTime != 0) {
+    if (txCap == 0) {
+      // Unbuffered (bit-banged) transmitter: the caller spins for the whole byte
+      simAdvanceMicros(byteTime);
+      txBlockedMicros += byteTime;
+    } else if (txQueued >= txCap) {
+      // Buffer full: spin until the oldest byte has been shifted out
+      uint64_t wait = txLastDrain + byteTime - simMicros();
+      simAdvanceMicros(wait);
+      txBlockedMicros += wait;
+      pump();
+    }
+    if (txCap != 0) {
+      if (txQueued == 0) txLastDrain = simMicros();
+      txQueued++;
+    }
+  }
+  txBytes++;
+  if (txSink) txSink(c, txSinkCtx);
+  return 1;
+}
+
+int SimUart::availableForWrite() {
+  pump();
+  return (int)(txCap - txQueued);
+}
+
+void SimUart::flush() {
+  pump();
+  uint32_t byteTime = byteTimeMicros();
+  if (txQueued == 0 || byteTime == 0) return;
+  uint64_t wait = txLastDrain + (uint64_t)txQueued * byteTime - simMicros();
+  simAdvanceMicros(wait);
+  txBlockedMicros += wait;
+  pump();
+}
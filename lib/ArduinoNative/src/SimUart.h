@@ -0,0 +1,63 @@
+#ifndef ARDUINO_NATIVE_SIM_UART_H
+#define ARDUINO_NATIVE_SIM_UART_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+
+// Line-rate model of a UART on the virtual clock.
+// Bytes injected by the host arrive one byte-time apart and are dropped
+// (and counted) when the receive buffer is full. Bytes written by the
+// firmware occupy the TX buffer until they have been shifted out; writing
+// into a full buffer blocks, which advances the virtual clock exactly like
+// the real Serial.write() spin would.
+class SimUart {
+public:
+  typedef void (*TxSink)(uint8_t c, void* ctx);
+
+  SimUart(size_t rxCapacity, size_t txCapacity);
+
+  void begin(unsigned long baud);
+  unsigned long baud() const { return baudRate; }
+  // Resize the buffers to model a different driver (clears buffered data)
+  void configure(size_t rxCapacity, size_t txCapacity);
+
+  // Host side
+  void inject(const uint8_t* data, size_t len);
+  void inject(const char* str);
+  size_t pendingInput() const { return pending.size(); }
+  void setTxSink(TxSink sink, void* ctx);
+
+  // Firmware side
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c);
+  int availableForWrite();
+  void flush();
+
+  // Statistics
+  unsigned long rxDelivered;
+  unsigned long rxOverflows;
+  unsigned long txBytes;
+  uint64_t txBlockedMicros;
+
+  void reset();
+
+private:
+  void pump();
+  uint32_t byteTimeMicros() const;
+
+  size_t rxCap;
+  size_t txCap;
+  unsigned long baudRate;
+  std::deque<uint8_t> pending;
+  std::deque<uint8_t> rx;
+  uint64_t nextArrival;
+  size_t txQueued;
+  uint64_t txLastDrain;
+  TxSink txSink;
+  void* txSinkCtx;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "SoftwareSerial.h"
+#include "SimUart.h"
+#include "sim.h"
+
+SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverseLogic)
+  : port(simGpsPort()), lastOverflows(0) {
+  (void)receivePin;
+  (void)transmitPin;
+  (void)inverseLogic;
+}
+
+void SoftwareSerial::begin(long speed) {
+  port.begin((unsigned long)speed);
+}
+
+bool SoftwareSerial::overflow() {
+  port.available();
+  bool overflowed = port.rxOverflows != lastOverflows;
+  lastOverflows = port.rxOverflows;
+  return overflowed;
+}
+
+int SoftwareSerial::available() { return port.available(); }
+int SoftwareSerial::read() { return port.read(); }
+int SoftwareSerial::peek() { return port.peek(); }
+size_t SoftwareSerial::write(uint8_t c) { return port.write(c); }
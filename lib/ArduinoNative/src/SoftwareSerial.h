@@ -0,0 +1,33 @@
+#ifndef ARDUINO_NATIVE_SOFTWARE_SERIAL_H
+#define ARDUINO_NATIVE_SOFTWARE_SERIAL_H
+
+#include "Arduino.h"
+
+class SimUart;
+
+// Bit-banged UART. The firmware only uses one (the GPS receiver), so every
+// instance is backed by the simulated GPS port. Like the AVR library, the
+// receive buffer holds 64 bytes and each transmitted byte blocks the caller
+// for a full byte time.
+class SoftwareSerial : public Stream {
+public:
+  SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverseLogic = false);
+
+  void begin(long speed);
+  void end() {}
+  bool listen() { return true; }
+  bool isListening() { return true; }
+  bool overflow();
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() { return true; }
+
+private:
+  SimUart& port;
+  unsigned long lastOverflows;
+};
+
+#endif
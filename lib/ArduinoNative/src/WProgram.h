@@ -0,0 +1,2 @@
+// Pre-1.0 Arduino header name, still included by some libraries
+#include "Arduino.h"
@@ -0,0 +1,10 @@
+#ifndef ARDUINO_NATIVE_AVR_EEPROM_H
+#define ARDUINO_NATIVE_AVR_EEPROM_H
+
+// EEPROM write status on the host. A byte write keeps the EEPROM busy for
+// 3.3 ms of virtual time, as EEPE does on the ATmega328; writing again
+// before then spins until the previous write is done.
+
+bool eeprom_is_ready();
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef ARDUINO_NATIVE_PGMSPACE_H
+#define ARDUINO_NATIVE_PGMSPACE_H
+
+// Program memory is ordinary memory on the host: PROGMEM data stays in the
+// data segment and the pgm_read_* accessors are plain loads.
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t*>(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef ARDUINO_NATIVE_SIM_H
+#define ARDUINO_NATIVE_SIM_H
+
+// Simulation controls for the host build, used by host drivers (benchmarks,
+// replayers) to stimulate inputs, observe outputs and move the virtual clock.
+// Firmware only includes it from host-only branches, to reach simulated
+// peripherals that have no Arduino API (e.g. the timer-driven GPS UART).
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SimUart.h"
+
+// Virtual clock. millis()/micros() read it, delay() advances it.
+uint64_t simMicros();
+void simAdvanceMicros(uint64_t us);
+void simAdvanceMillis(unsigned long ms);
+
+// Digital pins: inputs are driven by the host, outputs are latched from
+// digitalWrite(). The write hook fires on every digitalWrite() call.
+typedef void (*SimPinWriteHook)(uint8_t pin, uint8_t level, void* ctx);
+void simSetPin(uint8_t pin, uint8_t level);
+uint8_t simGetPin(uint8_t pin);
+uint8_t simGetPinMode(uint8_t pin);
+void simOnPinWrite(SimPinWriteHook hook, void* ctx);
+
+// ADC channels, addressed by pin (A0..A7) or channel number (0..7)
+void simSetAnalog(uint8_t pin, int value);
+int simGetAnalog(uint8_t pin);  // Instant, for peripheral models (no analogRead() cost)
+unsigned long simAnalogReads();
+
+// UARTs: the hardware Serial (ESP32 link) and the GPS receiver
+SimUart& simSerialPort();
+SimUart& simGpsPort();
+
+// EEPROM contents (non-volatile: simReset() leaves them alone) and the
+// number of byte writes, each of which wears a cell
+uint8_t* simEepromData();
+size_t simEepromSize();
+unsigned long simEepromWrites();
+
+// Restores power-on state: clock at zero, pins floating low, ports empty
+void simReset();
+
+#endif
@@ -0,0 +1,132 @@
+#include "adc.h"
+#include "headlights.h"
+
+#if !defined(__AVR__)
+#include <sim.h>
+#endif
+
+// ADC scanner configuration
+const uint8_t ADC_SCAN_OVERSAMPLE = 16;            // 16 x 10 bits fits the 16-bit sum
+const uint16_t ADC_SCAN_CONVERSION_MICROS = 104;   // 13 ADC clocks at 125 kHz (16 MHz / 128)
+
+static const uint8_t ADC_SCAN_SETTLE_SAMPLES = 1;  // Results discarded after a mux change
+static const uint8_t ADC_SCAN_PINS[ADC_SCAN_CHANNELS] = {PHOTOSENSOR_PIN, JOYSTICK_Y_PIN};
+
+// Per-channel result registers, written by the conversion-complete interrupt
+static volatile uint16_t adcResults[ADC_SCAN_CHANNELS];
+static volatile unsigned long adcSampleTimes[ADC_SCAN_CHANNELS];
+static volatile uint8_t adcResultsReady = 0;       // Bit per channel with at least one result
+static volatile unsigned long adcConversions = 0;
+
+// Scan state (interrupt context only)
+static uint8_t scanChannel = 0;
+static uint8_t scanCount = 0;
+static uint16_t scanSum = 0;
+
+static void selectAdcInput(uint8_t channel) {
+#if defined(__AVR__)
+  // AVcc reference, right-adjusted result
+  ADMUX = _BV(REFS0) | (ADC_SCAN_PINS[channel] - A0);
+#else
+  (void)channel;  // The host model reads the channel from scanChannel
+#endif
+}
+
+static void onAdcConversion(uint16_t sample, unsigned long timestamp) {
+  adcConversions++;
+  if (scanCount++ < ADC_SCAN_SETTLE_SAMPLES) return;
+  scanSum += sample;
+  if (scanCount < ADC_SCAN_SETTLE_SAMPLES + ADC_SCAN_OVERSAMPLE) return;
+
+  adcResults[scanChannel] = scanSum / ADC_SCAN_OVERSAMPLE;
+  adcSampleTimes[scanChannel] = timestamp;
+  adcResultsReady |= (1 << scanChannel);
+  scanSum = 0;
+  scanCount = 0;
+  scanChannel = (scanChannel + 1) % ADC_SCAN_CHANNELS;
+  selectAdcInput(scanChannel);
+}
+
+#if defined(__AVR__)
+ISR(ADC_vect) {
+  onAdcConversion(ADC, millis());
+}
+
+static inline void updateAdcScanner() {}
+#else
+// Host model of the free-running ADC: conversions are replayed from the
+// virtual clock whenever a result is read. Like on the AVR, each conversion
+// samples the channel the mux was set to when it started, which is before
+// the interrupt of the previous conversion changed it.
+static uint64_t simNextConversionMicros = 0;
+static uint8_t simRunningChannel = 0;
+
+static void updateAdcScanner() {
+  uint64_t now = simMicros();
+  // After a long gap only the most recent rounds matter
+  uint64_t horizon = (uint64_t)4 * ADC_SCAN_CHANNELS * (ADC_SCAN_SETTLE_SAMPLES + ADC_SCAN_OVERSAMPLE) *
+                     ADC_SCAN_CONVERSION_MICROS;
+  if (now > simNextConversionMicros + horizon) {
+    uint64_t skipped = (now - horizon - simNextConversionMicros) / ADC_SCAN_CONVERSION_MICROS;
+    simNextConversionMicros += skipped * ADC_SCAN_CONVERSION_MICROS;
+  }
+  while (simNextConversionMicros <= now) {
+    uint8_t sampled = simRunningChannel;
+    simRunningChannel = scanChannel;
+    onAdcConversion(simGetAnalog(ADC_SCAN_PINS[sampled]), (unsigned long)(simNextConversionMicros / 1000));
+    simNextConversionMicros += ADC_SCAN_CONVERSION_MICROS;
+  }
+}
+#endif
+
+void setupAdcScanner() {
+  scanChannel = 0;
+  scanCount = 0;
+  scanSum = 0;
+  adcResultsReady = 0;
+  selectAdcInput(scanChannel);
+
+#if defined(__AVR__)
+  // Digital input buffers off on the analog inputs (less noise and current)
+  for (uint8_t channel = 0; channel < ADC_SCAN_CHANNELS; channel++) {
+    DIDR0 |= _BV(ADC_SCAN_PINS[channel] - A0);
+  }
+  // Free-running auto trigger, interrupt on completion, 16 MHz / 128 = 125 kHz
+  ADCSRB = 0;
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+#else
+  simRunningChannel = scanChannel;
+  simNextConversionMicros = simMicros() + ADC_SCAN_CONVERSION_MICROS;
+#endif
+
+  // Consumers read from the first tick on, so wait for one full round (~3.5 ms)
+  const uint8_t allChannels = (1 << ADC_SCAN_CHANNELS) - 1;
+  while (adcResultsReady != allChannels) {
+    delayMicroseconds(ADC_SCAN_CONVERSION_MICROS);
+    updateAdcScanner();
+  }
+}
+
+uint16_t readAdcChannel(uint8_t channel) {
+  updateAdcScanner();
+  noInterrupts();
+  uint16_t result = adcResults[channel];
+  interrupts();
+  return result;
+}
+
+unsigned long getAdcSampleTime(uint8_t channel) {
+  updateAdcScanner();
+  noInterrupts();
+  unsigned long timestamp = adcSampleTimes[channel];
+  interrupts();
+  return timestamp;
+}
+
+unsigned long getAdcConversions() {
+  updateAdcScanner();
+  noInterrupts();
+  unsigned long conversions = adcConversions;
+  interrupts();
+  return conversions;
+}
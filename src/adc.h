@@ -0,0 +1,32 @@
+#ifndef ADC_H
+#define ADC_H
+
+#include <Arduino.h>
+
+// Interrupt-driven ADC scanner for the photosensor (A0) and joystick (A1).
+// The ADC free-runs (auto-trigger) and the conversion-complete interrupt
+// round-robins the channels: each channel gets ADC_SCAN_OVERSAMPLE samples,
+// which are averaged into its result register with a timestamp, then the mux
+// moves on. Consumers read the latest result without starting or waiting for
+// a conversion. analogRead() must not be used while the scanner runs.
+//
+// The conversion that is already running when the mux changes still samples
+// the old channel, so the first result after every switch is discarded.
+
+enum AdcScanChannel : uint8_t {
+  ADC_SCAN_PHOTOSENSOR,
+  ADC_SCAN_JOYSTICK,
+  ADC_SCAN_CHANNELS
+};
+
+// ADC scanner configuration
+extern const uint8_t ADC_SCAN_OVERSAMPLE;          // Samples averaged per result (power of two)
+extern const uint16_t ADC_SCAN_CONVERSION_MICROS;  // One free-running conversion at /128 prescaler
+
+// ADC scanner functions
+void setupAdcScanner();                        // Starts the scan and waits for a first result per channel
+uint16_t readAdcChannel(uint8_t channel);      // Latest averaged result, 0-1023
+unsigned long getAdcSampleTime(uint8_t channel); // millis() when that result completed
+unsigned long getAdcConversions();
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef COMMAND_PARAMS_H
+#define COMMAND_PARAMS_H
+
+// Catalog of parameters that can be read and changed over the serial link:
+// X(variable, type, min, max). The command name is the variable's name; the
+// variable is a non-const global of the given type (INT = int, ULONG =
+// unsigned long, UINT32 = uint32_t), declared in its module's header.
+// A new value is used the next time the module reads it: timeouts that are
+// already running keep the delay they were armed with. Values are lost on
+// reset.
+#define COMMAND_PARAMS(X) \
+  X(LOW_LIGHT_THRESHOLD,            INT,    0,    1022)   \
+  X(DARK_THRESHOLD,                 INT,    1,    1023)   \
+  X(LIGHT_ON_DEBOUNCE_MS,           ULONG,  0,    600000) \
+  X(LIGHT_OFF_DEBOUNCE_MS,          ULONG,  0,    600000) \
+  X(DRL_TIMEOUT_MS,                 ULONG,  0,    600000) \
+  X(GPS_MOVING_SPEED_CENTI_KMH,     UINT32, 0,    20000)  \
+  X(GPS_PARKED_SPEED_CENTI_KMH,     UINT32, 0,    20000)  \
+  X(REVERSE_GEAR_SETTLE_MS,         ULONG,  1,    1000)   \
+  X(CAMERA_AUTO_OFF_TIMEOUT_MS,     ULONG,  1000, 600000) \
+  X(CAMERA_MANUAL_TIMEOUT_MS,       ULONG,  1000, 600000) \
+  X(HORN_MAX_DURATION_MS,           ULONG,  500,  30000)  \
+  X(GPS_REPORT_MOVING_INTERVAL_MS,  ULONG,  200,  60000)  \
+  X(GPS_REPORT_PARKED_INTERVAL_MS,  ULONG,  200,  600000) \
+  X(TELEMETRY_KEYFRAME_INTERVAL_MS, ULONG,  1000, 600000)
+
+// Pairs of parameters that must keep their order: X(lower, higher, strict).
+// A SET that would break one is refused with CFG_ERR:range and the range the
+// other value leaves.
+// - Parked speed above moving speed would make isCarMoving() flip on every fix
+//   between the two.
+// - classifyLightLevel() only returns LOW_LIGHT for levels from
+//   LOW_LIGHT_THRESHOLD up to DARK_THRESHOLD, so that band must not be empty.
+#define COMMAND_PARAM_ORDER(X) \
+  X(GPS_PARKED_SPEED_CENTI_KMH, GPS_MOVING_SPEED_CENTI_KMH, false) \
+  X(LOW_LIGHT_THRESHOLD,        DARK_THRESHOLD,             true)
+
+#endif
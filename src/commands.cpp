@@ -0,0 +1,445 @@
+#include "commands.h"
+#include "command_params.h"
+#include "events.h"
+#include "gps.h"
+#include "gps_uart.h"
+#include "headlights.h"
+#include "horn.h"
+#include "log.h"
+#include "memstat.h"
+#include "profiler.h"
+#include "reverse.h"
+#include "sequence.h"
+#include "telemetry.h"
+#include "trace.h"
+
+// Command interpreter configuration
+const char COMMAND_LINE_START = '$';
+const uint8_t COMMAND_BYTES_PER_PASS = 4;   // A read, a compare and a store each: ~1 us
+
+static const uint8_t COMMAND_LINE_MAX = 48;   // "SET TELEMETRY_KEYFRAME_INTERVAL_MS 4294967295" fits
+static const uint8_t COMMAND_TOKENS = 3;      // Verb, name, value
+static const uint8_t REPLY_LINE_MAX = 32;     // TX room asked for before a reply starts
+static const uint8_t REPLY_STEPS_PER_PASS = 2; // Characters (or digits) written per pass
+static const uint8_t REPLY_ARGS_MAX = 6;
+static const uint8_t REPLY_DIGITS = 10;
+
+// Replies: '#' prints the next argument, '$' the parameter's name
+static const char REPLY_PARAM_TEXT[] PROGMEM = "CFG:$,#";
+static const char REPLY_STATS_TEXT[] PROGMEM = "STATS:#,#,#,#,#,#";
+static const char REPLY_RANGE_TEXT[] PROGMEM = "CFG_ERR:range,#,#";
+static const char REPLY_PLAY_TEXT[] PROGMEM = "PLAY:$";
+static const char REPLY_BUSY_TEXT[] PROGMEM = "CFG_ERR:busy";
+static const char REPLY_LENGTH_TEXT[] PROGMEM = "CFG_ERR:length";
+static const char REPLY_UNKNOWN_TEXT[] PROGMEM = "CFG_ERR:unknown";
+static const char REPLY_SYNTAX_TEXT[] PROGMEM = "CFG_ERR:syntax";
+
+// Digits are found by subtraction: a 32-bit division costs ~40 us on the AVR
+static const uint32_t POWERS_OF_TEN[REPLY_DIGITS] PROGMEM = {
+  1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL, 1UL,
+};
+
+enum CommandParamType : uint8_t { COMMAND_PARAM_INT, COMMAND_PARAM_ULONG, COMMAND_PARAM_UINT32 };
+
+struct CommandParam {
+  PGM_P name;
+  void* value;
+  uint8_t type;     // CommandParamType
+  uint32_t min;
+  uint32_t max;
+};
+
+#define COMMAND_PARAM_NAME(name, type, min, max) static const char COMMAND_NAME_##name[] PROGMEM = #name;
+COMMAND_PARAMS(COMMAND_PARAM_NAME)
+#undef COMMAND_PARAM_NAME
+
+static const CommandParam COMMAND_PARAM_TABLE[] PROGMEM = {
+#define COMMAND_PARAM_ENTRY(name, type, min, max) {COMMAND_NAME_##name, &name, COMMAND_PARAM_##type, min, max},
+  COMMAND_PARAMS(COMMAND_PARAM_ENTRY)
+#undef COMMAND_PARAM_ENTRY
+};
+static const uint8_t COMMAND_PARAM_COUNT = sizeof(COMMAND_PARAM_TABLE) / sizeof(COMMAND_PARAM_TABLE[0]);
+
+enum CommandParamId : uint8_t {
+#define COMMAND_PARAM_ID(name, type, min, max) COMMAND_PARAM_ID_##name,
+  COMMAND_PARAMS(COMMAND_PARAM_ID)
+#undef COMMAND_PARAM_ID
+};
+
+struct CommandParamOrder {
+  uint8_t lower;    // CommandParamId
+  uint8_t higher;
+  bool strict;
+};
+
+static const CommandParamOrder COMMAND_PARAM_ORDER_TABLE[] PROGMEM = {
+#define COMMAND_PARAM_ORDER_ENTRY(lower, higher, strict) \
+  {COMMAND_PARAM_ID_##lower, COMMAND_PARAM_ID_##higher, strict},
+  COMMAND_PARAM_ORDER(COMMAND_PARAM_ORDER_ENTRY)
+#undef COMMAND_PARAM_ORDER_ENTRY
+};
+static const uint8_t COMMAND_PARAM_ORDER_COUNT =
+    sizeof(COMMAND_PARAM_ORDER_TABLE) / sizeof(COMMAND_PARAM_ORDER_TABLE[0]);
+
+enum CommandState : uint8_t {
+  COMMAND_READING,   // Collecting input bytes
+  COMMAND_LOOKUP,    // GET/SET: comparing the name with one table entry per pass
+  COMMAND_REPLY,     // Writing the reply a few characters per pass
+};
+
+enum CommandReply : uint8_t {
+  REPLY_PARAM,       // CFG: line of paramIndex
+  REPLY_STATS,
+  REPLY_SYNTAX,
+  REPLY_LENGTH,
+  REPLY_UNKNOWN,
+  REPLY_RANGE,       // rangeMin..rangeMax
+  REPLY_PLAY,        // Pattern playPattern started
+  REPLY_BUSY,
+};
+
+// Line being received, upper-cased and split into '\0'-terminated tokens as
+// the bytes arrive, without the start character
+static char line[COMMAND_LINE_MAX + 1];
+static uint8_t lineLength = 0;
+static bool inLine = false;
+static bool lineTooLong = false;
+static uint8_t tokenCount = 0;
+static bool tokenOpen = false;       // The last token is still growing
+static uint8_t nameStart = 0;        // Offset of the second token
+static bool valueValid = false;      // The third token is all digits
+static unsigned long commandValue = 0;
+
+// Command being executed
+static CommandState state = COMMAND_READING;
+static CommandReply reply = REPLY_SYNTAX;
+static bool setting = false;
+static bool listing = false;
+static uint8_t paramIndex = 0;
+static uint32_t rangeMin = 0;        // Allowed values of paramIndex, ordering included
+static uint32_t rangeMax = 0;
+static uint8_t playPattern = 0;      // SequencePattern
+
+// Reply being written
+static bool replyOpen = false;       // Started: the debug line is held
+static PGM_P replyText = nullptr;    // Next character of the reply, nullptr = text done
+static PGM_P replyName = nullptr;    // Parameter name being written
+static PGM_P replyParamName = nullptr;
+static uint32_t replyArgs[REPLY_ARGS_MAX];
+static uint8_t replyArgIndex = 0;
+static uint32_t replyNumber = 0;     // Rest of the number being written
+static uint8_t replyPower = REPLY_DIGITS; // Next POWERS_OF_TEN entry; REPLY_DIGITS = no number
+static uint8_t replyEndPending = 0;  // Bytes of "\r\n" still to write
+
+static void readParam(uint8_t index, CommandParam& param) {
+  memcpy_P(&param, &COMMAND_PARAM_TABLE[index], sizeof(CommandParam));
+}
+
+static unsigned long readValue(const CommandParam& param) {
+  // Every parameter has a non-negative range
+  switch (param.type) {
+    case COMMAND_PARAM_INT:    return (unsigned long)*(int*)param.value;
+    case COMMAND_PARAM_UINT32: return *(uint32_t*)param.value;
+    default:                   return *(unsigned long*)param.value;
+  }
+}
+
+static void writeValue(const CommandParam& param, unsigned long value) {
+  switch (param.type) {
+    case COMMAND_PARAM_INT:    *(int*)param.value = (int)value; break;
+    case COMMAND_PARAM_UINT32: *(uint32_t*)param.value = (uint32_t)value; break;
+    default:                   *(unsigned long*)param.value = value; break;
+  }
+}
+
+static void narrowRange(uint8_t index, uint32_t& min, uint32_t& max) {
+  // The parameter's own range, narrowed by the pairs it is part of
+  CommandParam param;
+  readParam(index, param);
+  min = param.min;
+  max = param.max;
+  for (uint8_t i = 0; i < COMMAND_PARAM_ORDER_COUNT; i++) {
+    CommandParamOrder order;
+    memcpy_P(&order, &COMMAND_PARAM_ORDER_TABLE[i], sizeof(CommandParamOrder));
+    if (order.lower == index) {
+      readParam(order.higher, param);
+      uint32_t limit = readValue(param) - (order.strict ? 1 : 0);
+      if (limit < max) max = limit;
+    } else if (order.higher == index) {
+      readParam(order.lower, param);
+      uint32_t limit = readValue(param) + (order.strict ? 1 : 0);
+      if (limit > min) min = limit;
+    }
+  }
+}
+
+static void finishCommand(CommandReply result) {
+  reply = result;
+  state = COMMAND_REPLY;
+}
+
+static void startCommand() {
+  if (lineTooLong) {
+    finishCommand(REPLY_LENGTH);
+    return;
+  }
+
+  line[lineLength] = '\0';
+  bool named = tokenCount >= 2;
+  bool valued = tokenCount == 3 && valueValid;
+
+  paramIndex = 0;
+  listing = false;
+  if (tokenCount > COMMAND_TOKENS || tokenCount == 0) {
+    finishCommand(REPLY_SYNTAX);
+  } else if (strcmp_P(line, PSTR("GET")) == 0 && tokenCount == 2) {
+    setting = false;
+    state = COMMAND_LOOKUP;
+  } else if (strcmp_P(line, PSTR("SET")) == 0 && valued) {
+    setting = true;
+    state = COMMAND_LOOKUP;
+  } else if (strcmp_P(line, PSTR("LIST")) == 0 && !named) {
+    listing = true;
+    finishCommand(REPLY_PARAM);
+  } else if (strcmp_P(line, PSTR("STATS")) == 0 && !named) {
+    finishCommand(REPLY_STATS);
+  } else if (strcmp_P(line, PSTR("PLAY")) == 0 && tokenCount == 2) {
+    // Three names: compared in this pass
+    playPattern = findSequencePattern(line + nameStart);
+    if (playPattern == SEQUENCE_PATTERNS) {
+      finishCommand(REPLY_UNKNOWN);
+    } else {
+      finishCommand(startSequence(playPattern) ? REPLY_PLAY : REPLY_BUSY);
+    }
+  } else {
+    finishCommand(REPLY_SYNTAX);
+  }
+}
+
+static void appendToLine(char c) {
+  if (lineLength < COMMAND_LINE_MAX) {
+    line[lineLength++] = c;
+  } else {
+    lineTooLong = true;
+  }
+}
+
+static void addLineByte(char c) {
+  if (c == ' ') {
+    if (tokenOpen) appendToLine('\0');
+    tokenOpen = false;
+    return;
+  }
+  if (!tokenOpen) {
+    tokenOpen = true;
+    if (++tokenCount == 2) nameStart = lineLength;
+    if (tokenCount == 3) {
+      valueValid = true;
+      commandValue = 0;
+    }
+  }
+  if (tokenCount == 3) {
+    // Value parsed as it arrives; anything past 9 digits saturates (beyond every range)
+    if (c < '0' || c > '9') {
+      valueValid = false;
+    } else if (commandValue < 100000000UL) {
+      commandValue = commandValue * 10 + (c - '0');
+    } else {
+      commandValue = 0xFFFFFFFFUL;
+    }
+  }
+  appendToLine((c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c);
+}
+
+static void handleRequestByte(char request) {
+  // Single-byte requests from before the command syntax, still used by the ESP32
+  if (request == TELEMETRY_KEYFRAME_REQUEST) requestTelemetryKeyframe();
+  if (request == MEMORY_REPORT_REQUEST) requestMemoryReport();
+#if PROFILER
+  if (request == PROFILER_REPORT_REQUEST) requestProfilerReport();
+  if (request == PROFILER_RESET_REQUEST) resetProfiler();
+#endif
+}
+
+static void readInput() {
+  for (uint8_t i = 0; i < COMMAND_BYTES_PER_PASS && Serial.available() > 0; i++) {
+    char c = (char)Serial.read();
+#if TRACE_RECORD
+    traceSerialByte((uint8_t)c);
+#endif
+    if (c == COMMAND_LINE_START) {
+      // Also drops a line left unfinished, e.g. by an ESP32 reset
+      inLine = true;
+      lineLength = 0;
+      lineTooLong = false;
+      tokenCount = 0;
+      tokenOpen = false;
+    } else if (!inLine) {
+      handleRequestByte(c);
+    } else if (c == '\r' || c == '\n') {
+      inLine = false;
+      startCommand();
+      return;   // Further input waits in the RX buffer until this one is answered
+    } else {
+      addLineByte(c);
+    }
+  }
+}
+
+static void lookupParam() {
+  CommandParam param;
+  readParam(paramIndex, param);
+  if (strcmp_P(line + nameStart, param.name) != 0) {
+    if (++paramIndex == COMMAND_PARAM_COUNT) finishCommand(REPLY_UNKNOWN);
+    return;
+  }
+  if (setting) {
+    narrowRange(paramIndex, rangeMin, rangeMax);
+    if (commandValue < rangeMin || commandValue > rangeMax) {
+      finishCommand(REPLY_RANGE);
+      return;
+    }
+    writeValue(param, commandValue);
+  }
+  finishCommand(REPLY_PARAM);
+}
+
+static void beginReply() {
+  // Arguments are taken when the line starts, so they are consistent with each other
+  replyArgIndex = 0;
+  replyName = nullptr;
+  replyPower = REPLY_DIGITS;
+  replyEndPending = 2;
+
+  switch (reply) {
+    case REPLY_PARAM: {
+      CommandParam param;
+      readParam(paramIndex, param);
+      replyParamName = param.name;
+      replyArgs[0] = readValue(param);
+      replyText = REPLY_PARAM_TEXT;
+      break;
+    }
+    case REPLY_STATS:
+      replyArgs[0] = millis();
+      replyArgs[1] = getGpsUartOverflows() + getGpsUartFramingErrors();
+      replyArgs[2] = getEventsDropped();
+      replyArgs[3] = getLogDropped();
+      replyArgs[4] = getReverseEdgeOverruns();
+      replyArgs[5] = getHornSwitchMaxMicros();
+      replyText = REPLY_STATS_TEXT;
+      break;
+    case REPLY_RANGE:
+      replyArgs[0] = rangeMin;
+      replyArgs[1] = rangeMax;
+      replyText = REPLY_RANGE_TEXT;
+      break;
+    case REPLY_PLAY:
+      replyParamName = getSequencePatternName(playPattern);
+      replyText = REPLY_PLAY_TEXT;
+      break;
+    case REPLY_BUSY:
+      replyText = REPLY_BUSY_TEXT;
+      break;
+    case REPLY_LENGTH:
+      replyText = REPLY_LENGTH_TEXT;
+      break;
+    case REPLY_UNKNOWN:
+      replyText = REPLY_UNKNOWN_TEXT;
+      break;
+    default:
+      replyText = REPLY_SYNTAX_TEXT;
+      break;
+  }
+}
+
+static void startNumber(uint32_t value) {
+  replyNumber = value;
+  replyPower = 0;
+  while (replyPower < REPLY_DIGITS - 1 && value < pgm_read_dword(&POWERS_OF_TEN[replyPower])) {
+    replyPower++;
+  }
+}
+
+// Writes up to REPLY_STEPS_PER_PASS characters; true once the line is complete
+static bool writeReply() {
+  for (uint8_t step = 0; step < REPLY_STEPS_PER_PASS; step++) {
+    if (Serial.availableForWrite() == 0) return false;
+
+    if (replyPower < REPLY_DIGITS) {
+      // At most 9 subtractions per digit
+      uint32_t power = pgm_read_dword(&POWERS_OF_TEN[replyPower++]);
+      char digit = '0';
+      while (replyNumber >= power) {
+        replyNumber -= power;
+        digit++;
+      }
+      Serial.write((uint8_t)digit);
+    } else if (replyName != nullptr) {
+      char c = (char)pgm_read_byte(replyName++);
+      if (c == '\0') {
+        replyName = nullptr;
+      } else {
+        Serial.write((uint8_t)c);
+      }
+    } else if (replyText != nullptr) {
+      char c = (char)pgm_read_byte(replyText++);
+      if (c == '#') {
+        startNumber(replyArgIndex < REPLY_ARGS_MAX ? replyArgs[replyArgIndex++] : 0);
+      } else if (c == '$') {
+        replyName = replyParamName;
+      } else if (c == '\0') {
+        replyText = nullptr;
+      } else {
+        Serial.write((uint8_t)c);
+      }
+    } else if (replyEndPending > 0) {
+      Serial.write((uint8_t)(replyEndPending == 2 ? '\r' : '\n'));
+      replyEndPending--;
+    }
+  }
+  return replyText == nullptr && replyEndPending == 0;
+}
+
+static void sendReply() {
+  if (!replyOpen) {
+    // Log lines and telemetry wait until this line is out
+    if (!openDebugLine(REPLY_LINE_MAX)) return;
+    replyOpen = true;
+    beginReply();
+  }
+  if (!writeReply()) return;
+  closeDebugLine();
+  replyOpen = false;
+
+  if (reply == REPLY_STATS) {
+    // The other reports follow as the link has room for them
+    requestMemoryReport();
+#if PROFILER
+    requestProfilerReport();
+#endif
+  }
+  // LIST: one line per parameter, the link released in between
+  if (listing && ++paramIndex < COMMAND_PARAM_COUNT) return;
+  listing = false;
+  state = COMMAND_READING;
+}
+
+void setupCommands() {
+  inLine = false;
+  lineLength = 0;
+  replyOpen = false;
+  state = COMMAND_READING;
+}
+
+void handleCommands() {
+  switch (state) {
+    case COMMAND_READING: readInput(); break;
+    case COMMAND_LOOKUP:  lookupParam(); break;
+    case COMMAND_REPLY:   sendReply(); break;
+  }
+}
+
+bool isCommandPending() {
+  return state != COMMAND_READING || Serial.available() > 0;
+}
@@ -0,0 +1,43 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <Arduino.h>
+
+// Serial command interpreter for the ESP32 link.
+// The only reader of Serial: single request bytes (keyframe, memory and
+// profiler queries) keep their meaning, and a line starting with
+// COMMAND_LINE_START is a text command, ended by CR or LF:
+//   $GET <name>          -> CFG:<name>,<value>
+//   $SET <name> <value>  -> CFG:<name>,<value>
+//   $LIST                -> CFG:<name>,<value> for every parameter
+//   $STATS               -> STATS:<uptime ms>,<GPS bytes dropped>,<events dropped>,
+//                                 <log messages dropped>,<reverse edge overruns>,
+//                                 <horn switch max us>
+//                           followed by the MEM: (and PROF:) reports
+//   $PLAY <pattern>      -> PLAY:<pattern> once the output sequence has started
+//                           (FLASH, HAZARD, CHIRP; CFG_ERR:busy if it cannot)
+// Errors answer CFG_ERR:<reason> (syntax, length, unknown, range, busy) or, for an
+// out of range value, CFG_ERR:range,<min>,<max> (narrowed by the ordered
+// pairs of COMMAND_PARAM_ORDER). Names are those of
+// command_params.h, case-insensitive.
+//
+// Each pass costs a few microseconds at most, even under a flood of input:
+// - up to COMMAND_BYTES_PER_PASS bytes are read, tokenized and parsed as
+//   they arrive;
+// - the name lookup compares one table entry per pass;
+// - replies are written two characters per pass from flash templates, digits
+//   by subtraction (no 32-bit division), while the debug line is held so
+//   log and telemetry output wait instead of interleaving.
+// Input that arrives meanwhile stays in the RX buffer, so the ESP32 sends
+// one command and waits for its reply.
+
+// Command interpreter configuration
+extern const char COMMAND_LINE_START;
+extern const uint8_t COMMAND_BYTES_PER_PASS;
+
+// Command interpreter functions
+void setupCommands();
+void handleCommands();
+bool isCommandPending();   // Scheduler ready check: input waiting or a command in progress
+
+#endif
@@ -0,0 +1,84 @@
+#include "events.h"
+#include "log.h"
+
+static const uint8_t EVENT_QUEUE_SIZE = 8; // Per ring, power of two
+
+// Single-producer/single-consumer ring: the producer only writes head, the
+// consumer only writes tail, and each index is published after its slot
+struct EventRing {
+  volatile Event slots[EVENT_QUEUE_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile unsigned long dropped;
+};
+
+static EventRing loopEvents;
+static EventRing isrEvents;
+
+static const EventSubscriber* subscriberTable = nullptr;
+static uint8_t subscriberCount = 0;
+static unsigned long reportedDropped = 0;
+
+static void pushEvent(EventRing& ring, uint8_t type, uint8_t arg, uint16_t value) {
+  uint8_t head = ring.head;
+  uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+  if (next == ring.tail) {
+    ring.dropped++;
+    return;
+  }
+  ring.slots[head].type = type;
+  ring.slots[head].arg = arg;
+  ring.slots[head].value = value;
+  ring.head = next;
+}
+
+static void dispatchRing(EventRing& ring) {
+  while (ring.tail != ring.head) {
+    uint8_t tail = ring.tail;
+    Event event;
+    event.type = ring.slots[tail].type;
+    event.arg = ring.slots[tail].arg;
+    event.value = ring.slots[tail].value;
+    ring.tail = (tail + 1) & (EVENT_QUEUE_SIZE - 1);
+
+    for (uint8_t i = 0; i < subscriberCount; i++) {
+      if (subscriberTable[i].type == event.type) subscriberTable[i].handler(event);
+    }
+  }
+}
+
+void setupEvents(const EventSubscriber* subscribers, uint8_t count) {
+  subscriberTable = subscribers;
+  subscriberCount = count;
+}
+
+void postEvent(uint8_t type, uint8_t arg, uint16_t value) {
+  pushEvent(loopEvents, type, arg, value);
+}
+
+void postEventFromIsr(uint8_t type, uint8_t arg, uint16_t value) {
+  pushEvent(isrEvents, type, arg, value);
+}
+
+bool isEventPending() {
+  return isrEvents.head != isrEvents.tail || loopEvents.head != loopEvents.tail;
+}
+
+void dispatchEvents() {
+  // Subscribers may post further events; they are dispatched in the same run
+  dispatchRing(isrEvents);
+  dispatchRing(loopEvents);
+
+  unsigned long dropped = getEventsDropped();
+  if (dropped != reportedDropped) {
+    reportedDropped = dropped;
+    logEvent(LOG_EVENT_EVENTS_DROPPED, (int32_t)dropped);
+  }
+}
+
+unsigned long getEventsDropped() {
+  noInterrupts();
+  unsigned long dropped = loopEvents.dropped + isrEvents.dropped;
+  interrupts();
+  return dropped;
+}
@@ -0,0 +1,50 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+
+// Event bus between the sensing and actuation modules.
+// Producers post small typed events; the "events" scheduler task hands each
+// one to the subscribers registered for its type in the table in main.cpp,
+// so consumers only do work when something actually changed.
+//
+// There are two single-producer/single-consumer rings, so neither side ever
+// needs a lock:
+//   - postEvent() from the loop (tasks, timer callbacks)
+//   - postEventFromIsr() from interrupt handlers. AVR interrupts don't nest,
+//     so all handlers together are one producer.
+// The loop is the only consumer. Order is kept within a ring; the interrupt
+// ring is dispatched first. A full ring drops the event and counts it.
+
+enum EventType : uint8_t {
+  EVENT_BUTTON_EDGE,         // arg: debounced presses, value: releases (PORTD input masks)
+  EVENT_HORN_SWITCHED,       // arg: horn on (fast path: switched by the ISR)
+  EVENT_REVERSE_CHANGED,     // arg: reverse gear engaged
+  EVENT_SPEED_CROSSED,       // arg: car moving (GPS speed crossed the moving/parked threshold)
+  EVENT_BRIGHTNESS_CHANGED,  // arg: BrightnessLevel, value: filtered light level
+  EVENT_GPS_FIX,             // A new position fix (once per navigation epoch)
+  EVENT_TYPES
+};
+
+struct Event {
+  uint8_t type;
+  uint8_t arg;
+  uint16_t value;
+};
+
+// One entry of the static subscriber table; a handler that takes several
+// event types has one entry per type
+struct EventSubscriber {
+  uint8_t type;
+  void (*handler)(const Event& event);
+};
+
+// Event bus functions
+void setupEvents(const EventSubscriber* subscribers, uint8_t count);
+void postEvent(uint8_t type, uint8_t arg = 0, uint16_t value = 0);
+void postEventFromIsr(uint8_t type, uint8_t arg = 0, uint16_t value = 0);
+bool isEventPending();   // Scheduler ready check
+void dispatchEvents();   // Runs the subscribers of every queued event
+unsigned long getEventsDropped();
+
+#endif
@@ -1,76 +1,250 @@
 #include "gps.h"
+#include "gps_uart.h"
+#include "ubx.h"
+#include "telemetry.h"
+#include "log.h"
+#include "events.h"
+#include "trace.h"
 
 // GPS configuration
-const int GPS_RX_PIN = 9;        // D9: GPS TX pin connected to Arduino digital pin
-const int GPS_TX_PIN = 8;        // D8: GPS RX pin connected to Arduino digital pin  
 const int GPS_BAUD_RATE = 9600;  // NEO-6M default baud rate
-const unsigned long GPS_UPDATE_INTERVAL_MS = 1000; // Update every 1 second
+
+// Reporting rate follows the car: every fix while moving, rarely while parked.
+// The two speed thresholds keep GPS jitter at standstill from toggling the
+// moving state, which the other modules get as EVENT_SPEED_CROSSED.
+unsigned long GPS_REPORT_MOVING_INTERVAL_MS = 200;         // Every navigation solution
+unsigned long GPS_REPORT_PARKED_INTERVAL_MS = 5000;
+uint32_t GPS_MOVING_SPEED_CENTI_KMH = 500;                 // 5 km/h
+uint32_t GPS_PARKED_SPEED_CENTI_KMH = 200;                 // 2 km/h
+
+// Receiver configuration sent at boot (UBX)
+const unsigned long GPS_CONFIG_BAUD_RATE = 19200;  // Raised baud rate; set to GPS_BAUD_RATE to keep the default
+const unsigned int GPS_NAV_INTERVAL_MS = 200;      // 5 Hz navigation solutions
+const unsigned long GPS_ACK_TIMEOUT_MS = 250;      // Per configuration message
+
+// NMEA sentences and their output rate (per navigation solution); only RMC and GGA are parsed
+static const uint8_t NMEA_OUTPUT_RATES[][2] = {
+  {0x03, 0},  // GSV
+  {0x02, 0},  // GSA
+  {0x05, 0},  // VTG
+  {0x01, 0},  // GLL
+  {0x04, 1},  // RMC
+  {0x00, 1},  // GGA
+};
 
 // GPS objects
+#if GPS_PARSER_TINYGPS
 TinyGPSPlus gps;
-SoftwareSerial gpsSerial(GPS_RX_PIN, GPS_TX_PIN);
+#else
+NmeaParser gps;
+#endif
+
+// GPS state variables (fixed point)
+static uint32_t lastSpeedCentiKmh = 0;  // km/h * 100
+static int32_t lastLatitudeE6 = 0;      // Micro-degrees
+static int32_t lastLongitudeE6 = 0;     // Micro-degrees
+static uint32_t lastFixDate = 0;        // UTC ddmmyy
+static uint32_t lastFixTime = 0;        // UTC hhmmsscc
+static unsigned long lastReportedOverflows = 0;
+static unsigned long gpsBaudRate = GPS_BAUD_RATE;
+static bool gpsConfigured = false;
+static bool carMoving = false;
+static bool fixPosted = false;          // EVENT_GPS_FIX sent for lastFixDate/lastFixTime
+static uint32_t postedFixTime = 0;
+
+static bool setNmeaOutputRates() {
+  for (uint8_t i = 0; i < sizeof(NMEA_OUTPUT_RATES) / sizeof(NMEA_OUTPUT_RATES[0]); i++) {
+    // CFG-MSG, short form: rate on the port the message arrives on
+    uint8_t payload[3] = {UBX_CLASS_NMEA, NMEA_OUTPUT_RATES[i][0], NMEA_OUTPUT_RATES[i][1]};
+    if (ubxSendConfig(UBX_CFG_MSG, payload, sizeof(payload), GPS_ACK_TIMEOUT_MS) != UBX_ACKED) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool setNavigationRate() {
+  // CFG-RATE: measurement interval (ms), one solution per measurement, GPS time
+  uint8_t payload[6] = {
+    (uint8_t)(GPS_NAV_INTERVAL_MS & 0xFF), (uint8_t)(GPS_NAV_INTERVAL_MS >> 8), 1, 0, 1, 0
+  };
+  return ubxSendConfig(UBX_CFG_RATE, payload, sizeof(payload), GPS_ACK_TIMEOUT_MS) == UBX_ACKED;
+}
+
+static void setPortBaudRate(unsigned long baud) {
+  // CFG-PRT for UART1: 8N1, UBX+NMEA in and out. The receiver switches
+  // immediately, so its ACK is sent at the new rate and is usually lost.
+  uint8_t payload[20] = {
+    1, 0, 0, 0,                                // Port 1, reserved, txReady off
+    0xD0, 0x08, 0x00, 0x00,                    // Mode: 8 data bits, no parity, 1 stop bit
+    (uint8_t)baud, (uint8_t)(baud >> 8), (uint8_t)(baud >> 16), (uint8_t)(baud >> 24),
+    0x03, 0x00, 0x03, 0x00,                    // In/out protocols: UBX + NMEA
+    0, 0, 0, 0                                 // Flags, reserved
+  };
+  ubxSend(UBX_CLASS_CFG, UBX_CFG_PRT, payload, sizeof(payload));
+  gpsUartFlush();
+}
 
-// GPS state variables
-static unsigned long lastGPSUpdate = 0;
-static float lastSpeed = 0.0;
-static float lastLatitude = 0.0;
-static float lastLongitude = 0.0;
+static bool configureReceiver() {
+  // Find the receiver: default baud first, then the raised baud it keeps
+  // when only the Arduino was reset.
+  if (!setNmeaOutputRates()) {
+    if (GPS_CONFIG_BAUD_RATE == (unsigned long)GPS_BAUD_RATE) return false;
+    gpsBaudRate = GPS_CONFIG_BAUD_RATE;
+    gpsUartBegin(gpsBaudRate);
+    if (!setNmeaOutputRates()) {
+      gpsBaudRate = GPS_BAUD_RATE;
+      gpsUartBegin(gpsBaudRate);
+      return false;
+    }
+  }
+  if (!setNavigationRate()) return false;
+
+  if (gpsBaudRate != GPS_CONFIG_BAUD_RATE) {
+    // Switch, then confirm at the new rate; go back if nothing answers there
+    setPortBaudRate(GPS_CONFIG_BAUD_RATE);
+    gpsUartBegin(GPS_CONFIG_BAUD_RATE);
+    if (setNavigationRate()) {
+      gpsBaudRate = GPS_CONFIG_BAUD_RATE;
+    } else {
+      gpsUartBegin(gpsBaudRate);
+      if (!setNavigationRate()) return false;
+    }
+  }
+  return true;
+}
 
 void setupGPS() {
-  // Initialize GPS serial communication
-  gpsSerial.begin(GPS_BAUD_RATE);
-  
-  // Reset last update time
-  lastGPSUpdate = millis();
+  // Initialize GPS serial communication (interrupt-driven, Timer1)
+  gpsUartBegin(GPS_BAUD_RATE);
+
+  // Trim the NMEA output to RMC+GGA and raise the update rate. Without a
+  // reply the receiver keeps its defaults (all sentences, 1 Hz), which the
+  // parser copes with.
+  gpsConfigured = configureReceiver();
+  if (gpsConfigured) {
+    logEvent(LOG_EVENT_GPS_CONFIGURED, GPS_NAV_INTERVAL_MS, (int32_t)gpsBaudRate);
+  } else {
+    logEvent(LOG_EVENT_GPS_NO_UBX);
+  }
+}
+
+bool isGPSConfigured() {
+  return gpsConfigured;
 }
 
 void handleGPS() {
   // Read GPS data from serial
-  while (gpsSerial.available() > 0) {
-    if (gps.encode(gpsSerial.read())) {
+  while (gpsUartAvailable() > 0) {
+    uint8_t c = gpsUartRead();
+#if TRACE_RECORD
+    traceGpsByte(c);
+#endif
+    if (gps.encode(c)) {
       // GPS data successfully parsed
+#if GPS_PARSER_TINYGPS
       if (gps.location.isValid()) {
-        lastLatitude = gps.location.lat();
-        lastLongitude = gps.location.lng();
+        lastLatitudeE6 = (int32_t)lround(gps.location.lat() * 1e6);
+        lastLongitudeE6 = (int32_t)lround(gps.location.lng() * 1e6);
+        lastFixDate = gps.date.value();
+        lastFixTime = gps.time.value();
       }
       
       if (gps.speed.isValid()) {
-        lastSpeed = gps.speed.kmph(); // Speed in km/h
+        lastSpeedCentiKmh = (uint32_t)lround(gps.speed.kmph() * 100); // Speed in km/h
       }
+#else
+      if (gps.isLocationValid()) {
+        lastLatitudeE6 = gps.latitudeE6();
+        lastLongitudeE6 = gps.longitudeE6();
+        lastFixDate = gps.date();
+        lastFixTime = gps.timeCentis();
+      }
+      
+      if (gps.isSpeedValid()) {
+        lastSpeedCentiKmh = gps.speedCentiKmh(); // Speed in km/h * 100
+      }
+#endif
     }
   }
-  
-  // Send GPS data at regular intervals
-  if (millis() - lastGPSUpdate >= GPS_UPDATE_INTERVAL_MS) {
-    sendGPSData();
-    lastGPSUpdate = millis();
+
+  // Moving/parked with hysteresis, announced when it flips
+  bool moving = lastSpeedCentiKmh >= (carMoving ? GPS_PARKED_SPEED_CENTI_KMH : GPS_MOVING_SPEED_CENTI_KMH);
+  if (moving != carMoving) {
+    carMoving = moving;
+    postEvent(EVENT_SPEED_CROSSED, moving);
+  }
+
+  // One fix event per navigation epoch (RMC and GGA both carry the time)
+  if (isGPSValid() && (!fixPosted || lastFixTime != postedFixTime)) {
+    fixPosted = true;
+    postedFixTime = lastFixTime;
+    postEvent(EVENT_GPS_FIX);
+  }
+
+  // Report receive buffer overflows (bytes lost while the loop was busy)
+  unsigned long overflows = getGpsUartOverflows();
+  if (overflows != lastReportedOverflows) {
+    lastReportedOverflows = overflows;
+    logEvent(LOG_EVENT_GPS_RX_OVERFLOW, (int32_t)overflows);
   }
 }
 
+bool isGPSDataWaiting() {
+  return gpsUartAvailable() > 0;
+}
+
 void sendGPSData() {
-  if (isGPSValid()) {
-    // Send speed data
-    Serial.print("SPEED:");
-    Serial.println(lastSpeed, 2);
-    
-    // Send location data
-    Serial.print("LOCATION:");
-    Serial.print(lastLatitude, 6);
-    Serial.print(",");
-    Serial.println(lastLongitude, 6);
-  }
+  // Called every GPS_NAV_INTERVAL_MS; reports every GPS_REPORT_MOVING_INTERVAL_MS
+  // while moving, GPS_REPORT_PARKED_INTERVAL_MS while parked
+  static unsigned long lastReportTime = 0;
+  static bool reported = false;
+
   // Don't send anything if GPS data is invalid
+  if (!isGPSValid()) return;
+
+  unsigned long interval = carMoving ? GPS_REPORT_MOVING_INTERVAL_MS : GPS_REPORT_PARKED_INTERVAL_MS;
+  unsigned long now = millis();
+  if (reported && now - lastReportTime < interval) return;
+  reported = true;
+  lastReportTime = now;
+
+  // Publish speed and location with the next telemetry tick
+  publishSpeed(lastSpeedCentiKmh);
+  publishLocation(lastLatitudeE6, lastLongitudeE6);
 }
 
 bool isGPSValid() {
+#if GPS_PARSER_TINYGPS
   return gps.location.isValid() && gps.speed.isValid();
+#else
+  return gps.isLocationValid() && gps.isSpeedValid();
+#endif
+}
+
+bool isCarMoving() {
+  return carMoving;
 }
 
 float getSpeed() {
-  return lastSpeed;
+  return lastSpeedCentiKmh / 100.0f;
 }
 
 void getLocation(float& latitude, float& longitude) {
-  latitude = lastLatitude;
-  longitude = lastLongitude;
+  latitude = lastLatitudeE6 / 1e6f;
+  longitude = lastLongitudeE6 / 1e6f;
+}
+
+uint32_t getSpeedCentiKmh() {
+  return lastSpeedCentiKmh;
+}
+
+void getLocationE6(int32_t& latitudeE6, int32_t& longitudeE6) {
+  latitudeE6 = lastLatitudeE6;
+  longitudeE6 = lastLongitudeE6;
+}
+
+void getFixDateTime(uint32_t& ddmmyy, uint32_t& hhmmsscc) {
+  ddmmyy = lastFixDate;
+  hhmmsscc = lastFixTime;
 }
@@ -2,25 +2,49 @@
 #define GPS_H
 
 #include <Arduino.h>
-#include <SoftwareSerial.h>
+
+// NMEA parser: 0 = in-tree fixed-point RMC/GGA parser, 1 = TinyGPSPlus
+#ifndef GPS_PARSER_TINYGPS
+#define GPS_PARSER_TINYGPS 0
+#endif
+
+#if GPS_PARSER_TINYGPS
 #include <TinyGPS++.h>
+#else
+#include "nmea.h"
+#endif
 
 // GPS configuration
-extern const int GPS_RX_PIN;        // GPS TX pin connected to Arduino digital pin
-extern const int GPS_TX_PIN;        // GPS TX pin connected to Arduino digital pin
+constexpr uint8_t GPS_RX_PIN = 8; // D8 (ICP1): GPS TX pin connected to Arduino digital pin
+constexpr uint8_t GPS_TX_PIN = 9; // D9 (OC1A): GPS RX pin connected to Arduino digital pin
 extern const int GPS_BAUD_RATE;     // GPS module baud rate (usually 9600)
-extern const unsigned long GPS_UPDATE_INTERVAL_MS; // How often to update GPS data
+extern unsigned long GPS_REPORT_MOVING_INTERVAL_MS;       // How often to report GPS data while moving
+extern unsigned long GPS_REPORT_PARKED_INTERVAL_MS;       // How often to report GPS data while parked
+extern uint32_t GPS_MOVING_SPEED_CENTI_KMH;               // Speed from which the car counts as moving
+extern uint32_t GPS_PARKED_SPEED_CENTI_KMH;               // Speed below which it counts as parked again
+extern const unsigned long GPS_CONFIG_BAUD_RATE;   // Baud rate requested from the receiver at boot
+extern const unsigned int GPS_NAV_INTERVAL_MS;     // Navigation solution interval requested at boot
+extern const unsigned long GPS_ACK_TIMEOUT_MS;     // How long to wait for each UBX acknowledgement
 
 // GPS state variables
+#if GPS_PARSER_TINYGPS
 extern TinyGPSPlus gps;
-extern SoftwareSerial gpsSerial;
+#else
+extern NmeaParser gps;
+#endif
 
 // GPS functions
 void setupGPS();
+bool isGPSConfigured();
 void handleGPS();
+bool isGPSDataWaiting();
 void sendGPSData();
 bool isGPSValid();
+bool isCarMoving();   // Speed above GPS_MOVING_SPEED_CENTI_KMH, until it drops below GPS_PARKED_SPEED_CENTI_KMH
 float getSpeed();
 void getLocation(float& latitude, float& longitude);
+uint32_t getSpeedCentiKmh();
+void getLocationE6(int32_t& latitudeE6, int32_t& longitudeE6);
+void getFixDateTime(uint32_t& ddmmyy, uint32_t& hhmmsscc);
 
 #endif
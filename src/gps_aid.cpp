@@ -0,0 +1,118 @@
+#include "gps_aid.h"
+#include "gps.h"
+#include "ubx.h"
+#include "telemetry.h"
+#include "log.h"
+#include <EEPROM.h>
+#include <stddef.h>
+
+// GPS aiding configuration
+const int GPS_AID_EEPROM_ADDRESS = 0;
+const unsigned long GPS_AID_SAVE_INTERVAL_MS = 300000;   // 5 minutes: ~12 saves per hour of driving at most
+const int32_t GPS_AID_SAVE_MIN_DISTANCE_E6 = 1000;       // ~100 m
+const uint32_t GPS_AID_POSITION_ACCURACY_CM = 2000000;   // 20 km: covers 5 minutes of motorway after the last save
+
+static const uint8_t SAVED_FIX_VERSION = 1;
+
+// Last fix as stored in EEPROM
+struct SavedFix {
+  uint8_t version;
+  int32_t latitudeE6;
+  int32_t longitudeE6;
+  uint32_t date;      // UTC ddmmyy
+  uint32_t time;      // UTC hhmmsscc
+  uint8_t checksum;
+};
+
+static SavedFix savedFix;      // Also the record being written
+static bool savedFixValid = false;
+static uint8_t saveOffset = 0;  // Next byte of savedFix to write
+static bool savePending = false;
+static unsigned long lastSaveTime = 0;
+static unsigned long timeToFirstFix = 0;
+
+static uint8_t savedFixChecksum(const SavedFix& fix) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&fix);
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < offsetof(SavedFix, checksum); i++) sum += bytes[i];
+  return ~sum;
+}
+
+static void sendAidIni(const SavedFix& fix) {
+  // AID-INI: position as lat/lon (1e-7 deg) and altitude (cm), no time.
+  // The receiver has no use for the saved time: it does not know how long
+  // the car was parked, and its own RTC is better if it has one.
+  int32_t latitudeE7 = fix.latitudeE6 * 10;
+  int32_t longitudeE7 = fix.longitudeE6 * 10;
+  uint32_t accuracy = GPS_AID_POSITION_ACCURACY_CM;
+  uint8_t payload[48];
+  memset(payload, 0, sizeof(payload));
+  memcpy(payload + 0, &latitudeE7, 4);   // Little-endian on both AVR and x86
+  memcpy(payload + 4, &longitudeE7, 4);
+  memcpy(payload + 12, &accuracy, 4);
+  payload[44] = 0x21;                    // Flags: position valid, position given as LLA
+  ubxSend(UBX_CLASS_AID, UBX_AID_INI, payload, sizeof(payload));
+}
+
+static void saveFix() {
+  savedFix.version = SAVED_FIX_VERSION;
+  getLocationE6(savedFix.latitudeE6, savedFix.longitudeE6);
+  getFixDateTime(savedFix.date, savedFix.time);
+  savedFix.checksum = savedFixChecksum(savedFix);
+  // Written by writeSavedFix(); a save still in progress starts over
+  saveOffset = 0;
+  savePending = true;
+  savedFixValid = true;
+  lastSaveTime = millis();
+}
+
+void setupGPSAiding() {
+  EEPROM.get(GPS_AID_EEPROM_ADDRESS, savedFix);
+  savedFixValid = savedFix.version == SAVED_FIX_VERSION && savedFix.checksum == savedFixChecksum(savedFix);
+  if (!savedFixValid) {
+    logEvent(LOG_EVENT_GPS_AID_NONE);
+    return;
+  }
+
+  sendAidIni(savedFix);
+  logEvent(LOG_EVENT_GPS_AID_SENT, (int32_t)savedFix.date, (int32_t)(savedFix.time / 100));
+}
+
+void onGpsFixEvent(const Event&) {
+  // Once per navigation epoch with a valid fix
+  if (timeToFirstFix == 0) {
+    // First fix of this trip: report TTFF and save right away, so even a
+    // short trip leaves a fresh position for the next start
+    timeToFirstFix = millis();
+    publishTimeToFirstFix(timeToFirstFix);
+    saveFix();
+    return;
+  }
+
+  if (millis() - lastSaveTime < GPS_AID_SAVE_INTERVAL_MS) return;
+
+  int32_t latitudeE6, longitudeE6;
+  getLocationE6(latitudeE6, longitudeE6);
+  int32_t moved = labs(latitudeE6 - savedFix.latitudeE6) + labs(longitudeE6 - savedFix.longitudeE6);
+  if (moved >= GPS_AID_SAVE_MIN_DISTANCE_E6) {
+    saveFix();
+  }
+}
+
+bool isSavedFixPending() {
+  return savePending && eeprom_is_ready();
+}
+
+void writeSavedFix() {
+  if (!savePending || !eeprom_is_ready()) return;
+
+  // In order, so the checksum goes last (padding after it is not written).
+  // update() skips bytes that already hold the value.
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&savedFix);
+  EEPROM.update(GPS_AID_EEPROM_ADDRESS + saveOffset, bytes[saveOffset]);
+  if (saveOffset++ == offsetof(SavedFix, checksum)) savePending = false;
+}
+
+unsigned long getGPSTimeToFirstFix() {
+  return timeToFirstFix;
+}
@@ -0,0 +1,30 @@
+#ifndef GPS_AID_H
+#define GPS_AID_H
+
+#include <Arduino.h>
+#include "events.h"
+
+// Warm-start aiding for the GPS receiver.
+// The last fix is kept in EEPROM and handed to the receiver at boot as a
+// UBX AID-INI approximate position, so it does not have to search the whole
+// sky from scratch. There is no power-down signal, so the fix is saved on
+// the first fix of each trip and then periodically while moving.
+// A save is staged in RAM and written one byte per scheduler pass, each
+// once the previous EEPROM write has finished, so no pass waits the 3.3 ms
+// a byte write takes. The checksum is written last: a record cut short by a
+// power loss fails its checksum and is ignored at boot.
+
+// GPS aiding configuration
+extern const int GPS_AID_EEPROM_ADDRESS;
+extern const unsigned long GPS_AID_SAVE_INTERVAL_MS;   // Minimum time between saves while driving
+extern const int32_t GPS_AID_SAVE_MIN_DISTANCE_E6;     // Minimum movement (micro-degrees) before saving again
+extern const uint32_t GPS_AID_POSITION_ACCURACY_CM;    // Accuracy claimed for the saved position
+
+// GPS aiding functions
+void setupGPSAiding();
+void onGpsFixEvent(const Event& event);
+bool isSavedFixPending();       // Scheduler ready check: bytes left and EEPROM idle
+void writeSavedFix();           // Writes the next byte of the staged record
+unsigned long getGPSTimeToFirstFix();  // ms since boot, 0 until the first fix
+
+#endif
@@ -0,0 +1,263 @@
+#include "gps_uart.h"
+#include "fastpin.h"
+
+#if !defined(__AVR__)
+#include <sim.h>
+#endif
+
+// GPS UART configuration
+const uint8_t GPS_UART_RX_BUFFER_SIZE = 128; // Power of two; one full NMEA burst at 9600 baud is ~500 bytes/s
+const uint8_t GPS_UART_TX_BUFFER_SIZE = 64;  // Power of two; fits the largest configuration frame
+
+#if defined(__AVR__)
+
+// Receive state
+static volatile uint8_t rxBuffer[GPS_UART_RX_BUFFER_SIZE];
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxTail = 0;
+static volatile unsigned long rxOverflows = 0;
+static volatile unsigned long rxFramingErrors = 0;
+static uint8_t rxState = 0;        // 0 = idle, 1..8 = next data bit, 9 = waiting for stop bit
+static uint8_t rxByte = 0;
+static bool rxLineHigh = true;     // Line level since the last captured edge
+static uint16_t rxTarget = 0;      // Timer1 tick at the centre of the next data bit
+
+// Transmit state
+static volatile uint8_t txBuffer[GPS_UART_TX_BUFFER_SIZE];
+static volatile uint8_t txHead = 0;
+static volatile uint8_t txTail = 0;
+static volatile bool txBusy = false;
+static uint8_t txByte = 0;
+static uint8_t txBit = 0;          // Bit on the line: 0 = start, 1..8 = data, 9 = stop
+
+static uint16_t ticksPerBit = 0;
+
+static inline void captureFallingEdge() {
+  TCCR1B &= ~_BV(ICES1);
+  TIFR1 = _BV(ICF1); // Changing the edge can set a false capture flag
+}
+
+static inline void captureRisingEdge() {
+  TCCR1B |= _BV(ICES1);
+  TIFR1 = _BV(ICF1);
+}
+
+static inline void storeByte(uint8_t c) {
+  uint8_t head = (rxHead + 1) & (GPS_UART_RX_BUFFER_SIZE - 1);
+  if (head == rxTail) {
+    rxOverflows++;
+    return;
+  }
+  rxBuffer[rxHead] = c;
+  rxHead = head;
+}
+
+ISR(TIMER1_CAPT_vect) {
+  uint16_t captured = ICR1;
+
+  if (rxState == 0) {
+    // Falling edge while idle: start bit. Sample data bits at their centres
+    // and finish the byte at the centre of the stop bit.
+    rxTarget = captured + ticksPerBit + ticksPerBit / 2;
+    rxByte = 0;
+    rxState = 1;
+    rxLineHigh = false;
+    OCR1B = captured + ticksPerBit * 9 + ticksPerBit / 2;
+    TIFR1 = _BV(OCF1B);
+    TIMSK1 |= _BV(OCIE1B);
+    captureRisingEdge();
+    return;
+  }
+
+  // Every bit centre before this edge carried the previous line level
+  while (rxState <= 8 && (int16_t)(captured - rxTarget) > 0) {
+    rxByte = (rxByte >> 1) | (rxLineHigh ? 0x80 : 0);
+    rxTarget += ticksPerBit;
+    rxState++;
+  }
+
+  rxLineHigh = !rxLineHigh;
+  if (rxLineHigh) {
+    captureFallingEdge();
+  } else {
+    captureRisingEdge();
+  }
+}
+
+ISR(TIMER1_COMPB_vect) {
+  // Centre of the stop bit: remaining data bits carried the current level
+  while (rxState <= 8) {
+    rxByte = (rxByte >> 1) | (rxLineHigh ? 0x80 : 0);
+    rxState++;
+  }
+  TIMSK1 &= ~_BV(OCIE1B);
+
+  if (rxLineHigh) {
+    storeByte(rxByte);
+  } else {
+    rxFramingErrors++;
+  }
+
+  rxState = 0;
+  rxLineHigh = true;
+  captureFallingEdge();
+}
+
+static inline void setNextTxLevel(bool high) {
+  // Compare output mode: set OC1A on match (11) or clear on match (10)
+  if (high) {
+    TCCR1A |= _BV(COM1A0);
+  } else {
+    TCCR1A &= ~_BV(COM1A0);
+  }
+}
+
+ISR(TIMER1_COMPA_vect) {
+  // The level programmed for txBit has just been applied to D9
+  uint8_t bit = txBit + 1;
+  bool high;
+
+  if (bit <= 8) {
+    high = (txByte >> (bit - 1)) & 1;
+  } else if (bit == 9) {
+    high = true; // Stop bit
+  } else {
+    // Stop bit complete: next byte or idle with the line high
+    if (txHead == txTail) {
+      TIMSK1 &= ~_BV(OCIE1A);
+      txBusy = false;
+      return;
+    }
+    txByte = txBuffer[txTail];
+    txTail = (txTail + 1) & (GPS_UART_TX_BUFFER_SIZE - 1);
+    bit = 0;
+    high = false; // Start bit
+  }
+
+  txBit = bit;
+  setNextTxLevel(high);
+  OCR1A += ticksPerBit;
+}
+
+void gpsUartBegin(unsigned long baud) {
+  noInterrupts();
+  ticksPerBit = (uint16_t)((F_CPU / 8 + baud / 2) / baud);
+  rxHead = rxTail = 0;
+  rxState = 0;
+  rxLineHigh = true;
+  txHead = txTail = 0;
+  txBusy = false;
+
+  // D8 (ICP1) input, D9 (OC1A) output idling high
+  FastPin<8>::inputPullup();
+  FastPin<9>::high();
+  FastPin<9>::output();
+
+  // Timer1: normal mode, F_CPU/8, input capture noise canceller, falling edge.
+  // OC1A set on compare match; force a match so the pin is driven high.
+  TIMSK1 = 0;
+  TCCR1A = _BV(COM1A1) | _BV(COM1A0);
+  TCCR1B = _BV(ICNC1) | _BV(CS11);
+  TCCR1C = _BV(FOC1A);
+  TIFR1 = _BV(ICF1) | _BV(OCF1A) | _BV(OCF1B);
+  TIMSK1 = _BV(ICIE1);
+  interrupts();
+}
+
+int gpsUartAvailable() {
+  return (uint8_t)(rxHead - rxTail) & (GPS_UART_RX_BUFFER_SIZE - 1);
+}
+
+int gpsUartRead() {
+  uint8_t tail = rxTail;
+  if (rxHead == tail) return -1;
+  uint8_t c = rxBuffer[tail];
+  rxTail = (tail + 1) & (GPS_UART_RX_BUFFER_SIZE - 1);
+  return c;
+}
+
+size_t gpsUartWrite(uint8_t c) {
+  uint8_t head = (txHead + 1) & (GPS_UART_TX_BUFFER_SIZE - 1);
+  while (head == txTail) {
+    // Buffer full: wait for the ISR to take a byte (configuration at boot only)
+  }
+
+  noInterrupts();
+  if (!txBusy) {
+    // Idle: program the start bit a few microseconds ahead
+    txByte = c;
+    txBit = 0;
+    txBusy = true;
+    setNextTxLevel(false);
+    OCR1A = TCNT1 + 16;
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+  } else {
+    txBuffer[txHead] = c;
+    txHead = head;
+  }
+  interrupts();
+  return 1;
+}
+
+void gpsUartFlush() {
+  while (txBusy) {
+  }
+}
+
+unsigned long getGpsUartOverflows() {
+  noInterrupts();
+  unsigned long overflows = rxOverflows;
+  interrupts();
+  return overflows;
+}
+
+unsigned long getGpsUartFramingErrors() {
+  noInterrupts();
+  unsigned long errors = rxFramingErrors;
+  interrupts();
+  return errors;
+}
+
+#else
+
+// Host build: the simulated GPS port delivers bytes at line rate into a
+// buffer of the same size as the AVR driver's.
+
+void gpsUartBegin(unsigned long baud) {
+  simGpsPort().configure(GPS_UART_RX_BUFFER_SIZE - 1, GPS_UART_TX_BUFFER_SIZE - 1);
+  simGpsPort().begin(baud);
+}
+
+int gpsUartAvailable() {
+  return simGpsPort().available();
+}
+
+int gpsUartRead() {
+  return simGpsPort().read();
+}
+
+size_t gpsUartWrite(uint8_t c) {
+  return simGpsPort().write(c);
+}
+
+void gpsUartFlush() {
+  simGpsPort().flush();
+}
+
+unsigned long getGpsUartOverflows() {
+  return simGpsPort().rxOverflows;
+}
+
+unsigned long getGpsUartFramingErrors() {
+  return 0;
+}
+
+#endif
+
+size_t gpsUartWrite(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    gpsUartWrite(data[i]);
+  }
+  return len;
+}
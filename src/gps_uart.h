@@ -0,0 +1,27 @@
+#ifndef GPS_UART_H
+#define GPS_UART_H
+
+#include <Arduino.h>
+
+// Interrupt-driven UART for the GPS receiver on Timer1.
+// RX uses input capture on ICP1 (D8): the hardware latches the timer on each
+// line edge, so bits are decoded from edge timestamps without ever disabling
+// interrupts for a whole byte like SoftwareSerial does. TX uses output
+// compare OC1A (D9), which flips the pin at the exact bit boundaries.
+// Timer1 runs free at F_CPU/8 (2 MHz) and is owned by this module.
+
+// GPS UART configuration
+extern const uint8_t GPS_UART_RX_BUFFER_SIZE;
+extern const uint8_t GPS_UART_TX_BUFFER_SIZE;
+
+// GPS UART functions
+void gpsUartBegin(unsigned long baud);
+int gpsUartAvailable();
+int gpsUartRead();
+size_t gpsUartWrite(uint8_t c);
+size_t gpsUartWrite(const uint8_t* data, size_t len);
+void gpsUartFlush();
+unsigned long getGpsUartOverflows();      // Bytes dropped because the RX buffer was full
+unsigned long getGpsUartFramingErrors();  // Bytes dropped because the stop bit was low
+
+#endif
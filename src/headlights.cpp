@@ -1,29 +1,30 @@
 #include "headlights.h"
 #include "gps.h"
+#include "log.h"
+#include "outputs.h"
+#include "adc.h"
+#include "sequence.h"
+#include "timers.h"
+#include "events.h"
 #include <Arduino.h>
 
-// Headlight pin configuration
-const int PHOTOSENSOR_PIN = A0;       // A0: Photosensitive sensor DO pin (analog input)
-const int DRL_MOSFET_PIN = 11;        // D11: DRL MOSFET control
-const int TAIL_LIGHT_MOSFET_PIN = 7; // D7: Tail light MOSFET control
-const int LOW_BEAM_MOSFET_PIN = 13;   // D13: Low beam MOSFET control
-const int HIGH_BEAM_MOSFET_PIN = A2;  // A2: High beam MOSFET control
-const int JOYSTICK_Y_PIN = A1;        // A1: Joystick Y-axis analog pin
-
 // Timing configuration
-const unsigned long LIGHT_ON_DEBOUNCE_MS = 5000;   // 5 seconds debounce when turning lights ON
-const unsigned long LIGHT_OFF_DEBOUNCE_MS = 60000; // 1 minute debounce when turning lights OFF
-const unsigned long DRL_TIMEOUT_MS = 60000;        // 1 minute DRL timeout to avoid power competition during cranking
+unsigned long LIGHT_ON_DEBOUNCE_MS = 5000;         // 5 seconds debounce when turning lights ON
+unsigned long LIGHT_OFF_DEBOUNCE_MS = 60000;       // 1 minute debounce when turning lights OFF
+unsigned long DRL_TIMEOUT_MS = 60000;              // 1 minute DRL timeout to avoid power competition during cranking
 const unsigned long JOYSTICK_DEBOUNCE_MS = 200;     // 200ms debounce for joystick inputs
-const unsigned long BEAM_FLASH_DURATION_MS = 300;  // 300ms duration for each beam flash (relay-friendly)
-const unsigned long BEAM_FLASH_PAUSE_MS = 200;      // 200ms pause between flashes (relay-friendly)
+const unsigned long LIGHT_READING_INTERVAL_MS = 200; // Light level and speed are evaluated every 200ms
 
 // Light level thresholds (configurable - can be adjusted via serial commands)
-int LOW_LIGHT_THRESHOLD = 300;    // Threshold for low light detection (0-1023)
-int DARK_THRESHOLD = 150;         // Threshold for dark detection (0-1023)
+int LOW_LIGHT_THRESHOLD = 150;    // Threshold for low light detection (0-1023), below DARK_THRESHOLD
+int DARK_THRESHOLD = 300;         // Threshold for dark detection (0-1023)
+const int LIGHT_HYSTERESIS = 25;        // Level must be this far past a threshold to change class
+const uint8_t LIGHT_FILTER_SHIFT = 2;   // EMA weight 1/4 per sample (~0.8 s time constant)
 
-// Speed threshold
-const float DRL_ACTIVATION_SPEED_THRESHOLD = 5.0;  // Speed threshold for DRL activation
+// Tunnel fast path: a sharp, sustained darkening while moving switches on
+// low beam and tail lights without waiting for LIGHT_ON_DEBOUNCE_MS
+const int TUNNEL_LIGHT_RISE = 200;          // Sensor rise over the filtered level (darker = higher)
+const uint8_t TUNNEL_CONFIRM_SAMPLES = 3;   // Consecutive dark samples (~0.4-0.6 s)
 
 // Joystick analog thresholds (0-1023)
 const int JOYSTICK_UP_THRESHOLD = 800;     // Above this value = joystick pushed up
@@ -31,108 +32,92 @@ const int JOYSTICK_DOWN_THRESHOLD = 200;   // Below this value = joystick pushed
 const int JOYSTICK_CENTER_MIN = 400;       // Center position minimum
 const int JOYSTICK_CENTER_MAX = 600;       // Center position maximum
 
-// Headlight state variables
-bool drlActive = false;
-bool tailLightActive = false;
-BeamMode currentBeamMode = BEAM_OFF;
+// Headlight state
+static bool drlActive = false;
+static bool tailLightActive = false;
+static BeamMode currentBeamMode = BEAM_OFF;
 
-// Individual light state change tracking
-static unsigned long drlChangeRequestTime = 0;
+// Individual light state change tracking (applied by their debounce timers)
 static bool drlChangeRequested = false;
 static bool drlChangeToOn = false;
 
-static unsigned long tailLightChangeRequestTime = 0;
 static bool tailLightChangeRequested = false;
 static bool tailLightChangeToOn = false;
 
-static unsigned long beamModeChangeRequestTime = 0;
 static bool beamModeChangeRequested = false;
 static BeamMode beamModeChangeTo = BEAM_OFF;
 
 // DRL timeout tracking
-static unsigned long drlStartTime = 0;
-
-// Current stable states
-static int currentLightLevel = 0;
-static bool currentCarMoving = false;
+static bool drlTimeoutStarted = false;
+static bool drlTimeoutElapsed = false;
 
 // Joystick state tracking
 static bool joystickUpPressed = false;
 static bool joystickDownPressed = false;
-static unsigned long lastJoystickUpTime = 0;
-static unsigned long lastJoystickDownTime = 0;
-static bool beamFlashInProgress = false;
-static unsigned long beamFlashStartTime = 0;
-static int beamFlashStep = 0;
-static BeamMode previousBeamMode = BEAM_OFF;
 static int joystickYValue = 512;  // Center position (0-1023)
+static unsigned long joystickSampleTime = 0;  // ADC result last handled
+
+// Light level pipeline: EMA filter, then classifier with hysteresis
+static uint16_t lightFilterState = 0;    // Filtered level << LIGHT_FILTER_SHIFT
+static BrightnessLevel brightnessLevel = BRIGHT;
+
+// Tunnel detector state
+static uint8_t tunnelDarkSamples = 0;
+static int tunnelBaseline = 0;           // Filtered level before the first dark sample
+static unsigned long tunnelOnsetTime = 0;
 
-// Light level reading variables
-static int lightLevelReadings[5] = {0};  // Array for averaging readings
-static int readingIndex = 0;
-static unsigned long lastReadingTime = 0;
-static const unsigned long READING_INTERVAL_MS = 200;  // Read every 200ms
+static void updateLightLevel(uint16_t sample);
+static void detectTunnel(uint16_t sample);
+static void applyDrlChange();
+static void applyTailLightChange();
+static void applyBeamModeChange();
 
 void setupHeadlights() {
-  // Setup photosensitive sensor pin
-  pinMode(PHOTOSENSOR_PIN, INPUT);
-  
-  // Setup MOSFET control pins
-  pinMode(DRL_MOSFET_PIN, OUTPUT);
-  pinMode(TAIL_LIGHT_MOSFET_PIN, OUTPUT);
-  pinMode(LOW_BEAM_MOSFET_PIN, OUTPUT);
-  pinMode(HIGH_BEAM_MOSFET_PIN, OUTPUT);
-  
-  // Setup joystick pin (analog input)
-  pinMode(JOYSTICK_Y_PIN, INPUT);
-  
-  // Initialize all lights to OFF (active low relays)
-  digitalWrite(DRL_MOSFET_PIN, RELAY_OFF);
-  digitalWrite(TAIL_LIGHT_MOSFET_PIN, RELAY_OFF);
-  digitalWrite(LOW_BEAM_MOSFET_PIN, RELAY_OFF);
-  digitalWrite(HIGH_BEAM_MOSFET_PIN, RELAY_OFF);
+  // The photosensor and joystick are sampled by the ADC scanner, and the
+  // MOSFET control pins are set up (all OFF) by setupOutputs()
   
-  // Initialize current states
-  currentLightLevel = readLightLevel();
-  currentCarMoving = isCarMoving();
+  // Initialize current states; the filter starts at the first sample and the
+  // initial class is evaluated like any later change
+  lightFilterState = readAdcChannel(ADC_SCAN_PHOTOSENSOR) << LIGHT_FILTER_SHIFT;
+  brightnessLevel = classifyLightLevel(readLightLevel());
+  postEvent(EVENT_BRIGHTNESS_CHANGED, brightnessLevel, readLightLevel());
   
-  // Initialize DRL timeout - will be set when first bright condition is detected
-  drlStartTime = 0;
+  // Initialize DRL timeout - will be started when first bright condition is detected
+  drlTimeoutStarted = false;
+  drlTimeoutElapsed = false;
   
   // Headlight system initialized
 }
 
 void handleHeadlights() {
-  // Handle joystick inputs first (highest priority)
+  // Runs every LIGHT_READING_INTERVAL_MS from the scheduler: one light sample each,
+  // checked against the filtered level before it enters the filter
+  // This sensor outputs HIGHER values in DARKNESS, LOWER values in BRIGHT LIGHT
+  uint16_t sample = readAdcChannel(ADC_SCAN_PHOTOSENSOR);
+  detectTunnel(sample);
+  updateLightLevel(sample);
+}
+
+void onHeadlightEvent(const Event&) {
+  // Re-evaluate only when the brightness class or the moving state changed;
+  // the requested changes are applied by their debounce timers
+  calculateDesiredLightStates();
+}
+
+static void onDrlTimeout() {
+  drlTimeoutElapsed = true;
+  calculateDesiredLightStates();
+}
+
+void handleBeamControl() {
+  // Once per joystick result (~3.5 ms); beam flashing runs on its own from
+  // the sequence timer
+  joystickSampleTime = getAdcSampleTime(ADC_SCAN_JOYSTICK);
   handleJoystick();
-  
-  // Handle beam flashing if in progress
-  if (beamFlashInProgress) {
-    performBeamFlash();
-  }
-  
-  // Read light level and speed at regular intervals
-  if (millis() - lastReadingTime >= READING_INTERVAL_MS) {
-    int newLightLevel = readLightLevel();
-    bool newCarMoving = isCarMoving();
-    // Check if conditions have changed significantly
-    bool lightChanged = abs(newLightLevel - currentLightLevel) > 50;
-    bool speedChanged = (newCarMoving != currentCarMoving);
-    
-    if (lightChanged || speedChanged) {
-      // Update current states
-      currentLightLevel = newLightLevel;
-      currentCarMoving = newCarMoving;
-      
-      // Calculate desired light states
-      calculateDesiredLightStates();
-    }
-    
-    lastReadingTime = millis();
-  }
-  
-  // Apply light state changes with appropriate debounce
-  applyLightStateChanges();
+}
+
+bool isJoystickSampleNew() {
+  return getAdcSampleTime(ADC_SCAN_JOYSTICK) != joystickSampleTime;
 }
 
 void calculateDesiredLightStates() {
@@ -149,17 +134,12 @@ void calculateDesiredLightStates() {
       desiredTailLight = false;
       desiredBeamMode = BEAM_OFF;
       // DRL ON if timeout period has passed (once activated, stays on permanently)
-      if (drlStartTime == 0) {
-        // Start DRL timeout on first bright condition
-        drlStartTime = millis() + DRL_TIMEOUT_MS;
-        desiredDRL = false; // Not yet activated
-      } else if (millis() >= drlStartTime) {
-        // Timeout has passed, DRL should be permanently ON
-        desiredDRL = true;
-      } else {
-        // Still within timeout period, DRL stays OFF
-        desiredDRL = false;
+      if (!drlTimeoutStarted) {
+        // Start DRL timeout on first bright condition; it re-evaluates when done
+        drlTimeoutStarted = true;
+        armTimer(TIMER_DRL_TIMEOUT, DRL_TIMEOUT_MS, onDrlTimeout);
       }
+      desiredDRL = drlTimeoutElapsed;
       break;
       
     case LOW_LIGHT:
@@ -180,89 +160,42 @@ void calculateDesiredLightStates() {
   }
   
   // Check each light individually for changes
-  checkLightChange(desiredDRL, drlActive, drlChangeRequested, drlChangeRequestTime, drlChangeToOn, "DRL");
-  checkLightChange(desiredTailLight, tailLightActive, tailLightChangeRequested, tailLightChangeRequestTime, tailLightChangeToOn, "Tail Light");
+  checkLightChange(desiredDRL, drlActive, drlChangeRequested, drlChangeToOn, TIMER_DRL_CHANGE, applyDrlChange);
+  checkLightChange(desiredTailLight, tailLightActive, tailLightChangeRequested, tailLightChangeToOn, TIMER_TAIL_LIGHT_CHANGE, applyTailLightChange);
   
   // Handle beam mode changes with debounce (only if automatic system wants to change it)
+  // Different debounce times: 5sec for turning ON (LOW/HIGH), 60sec for turning OFF
   if (desiredBeamMode != currentBeamMode && !beamModeChangeRequested) {
     beamModeChangeRequested = true;
-    beamModeChangeRequestTime = millis();
     beamModeChangeTo = desiredBeamMode;
+    armTimer(TIMER_BEAM_MODE_CHANGE, desiredBeamMode == BEAM_OFF ? LIGHT_OFF_DEBOUNCE_MS : LIGHT_ON_DEBOUNCE_MS,
+             applyBeamModeChange);
   }
 }
 
-void checkLightChange(bool desired, bool current, bool& changeRequested, unsigned long& changeRequestTime, bool& changeToOn, const char* lightName) {
+void checkLightChange(bool desired, bool current, bool& changeRequested, bool& changeToOn, uint8_t timer, TimerCallback apply) {
   if (desired != current && !changeRequested) {
     changeRequested = true;
-    changeRequestTime = millis();
     changeToOn = desired;
+    armTimer(timer, desired ? LIGHT_ON_DEBOUNCE_MS : LIGHT_OFF_DEBOUNCE_MS, apply);
   }
 }
 
-void applyLightStateChanges() {
-  // Apply DRL changes
-  applyIndividualLightChange(drlChangeRequested, drlChangeRequestTime, drlChangeToOn, drlActive, setDRL, "DRL");
-  
-  // Apply Tail Light changes
-  applyIndividualLightChange(tailLightChangeRequested, tailLightChangeRequestTime, tailLightChangeToOn, tailLightActive, setTailLight, "Tail Light");
-  
-  // Apply Beam Mode changes with appropriate debounce timing
-  if (beamModeChangeRequested) {
-    unsigned long debounceTime;
-    
-    // Use different debounce times: 5sec for turning ON, 60sec for turning OFF
-    if (beamModeChangeTo == BEAM_OFF) {
-      debounceTime = LIGHT_OFF_DEBOUNCE_MS;  // 60 seconds for turning OFF
-    } else {
-      debounceTime = LIGHT_ON_DEBOUNCE_MS;   // 5 seconds for turning ON (LOW/HIGH)
-    }
-    
-    if (millis() - beamModeChangeRequestTime >= debounceTime) {
-      setBeamMode(beamModeChangeTo);
-      beamModeChangeRequested = false;
-    }
-  }
+static void applyDrlChange() {
+  drlChangeRequested = false;
+  setDRL(drlChangeToOn);
 }
 
-
-void applyIndividualLightChange(bool& changeRequested, unsigned long& changeRequestTime, bool& changeToOn, bool& currentState, void (*setFunction)(bool), const char* lightName) {
-  if (!changeRequested) return;
-  
-  unsigned long debounceTime = changeToOn ? LIGHT_ON_DEBOUNCE_MS : LIGHT_OFF_DEBOUNCE_MS;
-  
-  if (millis() - changeRequestTime >= debounceTime) {
-    setFunction(changeToOn);
-    currentState = changeToOn;
-    changeRequested = false;
-  }
+static void applyTailLightChange() {
+  tailLightChangeRequested = false;
+  setTailLight(tailLightChangeToOn);
 }
 
-bool isCarMoving() {
-  float speed = getSpeed();
-  return speed > DRL_ACTIVATION_SPEED_THRESHOLD;
+static void applyBeamModeChange() {
+  setBeamMode(beamModeChangeTo);
 }
 
-int readLightLevel() {
-  // Read analog value from photosensitive sensor
-  // This sensor outputs HIGHER values in DARKNESS, LOWER values in BRIGHT LIGHT
-  int reading = analogRead(PHOTOSENSOR_PIN);
-  
-  // Add to rolling average
-  lightLevelReadings[readingIndex] = reading;
-  readingIndex = (readingIndex + 1) % 5;
-  
-  // Calculate average
-  int sum = 0;
-  for (int i = 0; i < 5; i++) {
-    sum += lightLevelReadings[i];
-  }
-  
-  return sum / 5;
-}
-
-BrightnessLevel getBrightnessLevel() {
-  int lightLevel = readLightLevel();
-  
+BrightnessLevel classifyLightLevel(int lightLevel) {
   // Determine brightness level (sensor reversed: HIGH = dark, LOW = bright)
   if (lightLevel < LOW_LIGHT_THRESHOLD) {
     return BRIGHT;      // Low sensor value = bright day
@@ -273,22 +206,82 @@ BrightnessLevel getBrightnessLevel() {
   }
 }
 
+static void updateLightLevel(uint16_t sample) {
+  // Photosensor result from the ADC scanner (already averaged over
+  // ADC_SCAN_OVERSAMPLE conversions) into the EMA:
+  // state += sample - state / 2^LIGHT_FILTER_SHIFT
+  lightFilterState += sample - (lightFilterState >> LIGHT_FILTER_SHIFT);
+  int lightLevel = readLightLevel();
+
+  // Hysteresis: a new class is only taken once the level is LIGHT_HYSTERESIS
+  // inside it, so a level sitting on a threshold at dusk cannot flicker
+  BrightnessLevel level = classifyLightLevel(lightLevel);
+  if (level != brightnessLevel &&
+      classifyLightLevel(lightLevel - LIGHT_HYSTERESIS) == level &&
+      classifyLightLevel(lightLevel + LIGHT_HYSTERESIS) == level) {
+    brightnessLevel = level;
+    postEvent(EVENT_BRIGHTNESS_CHANGED, level, lightLevel);
+    logEvent(LOG_EVENT_BRIGHTNESS_CHANGED, (int32_t)level, lightLevel);
+  }
+}
+
+static void switchOnTunnelLights() {
+  // Straight to ON, cancelling any pending (e.g. OFF) request; turning
+  // them off later goes through the normal LIGHT_OFF_DEBOUNCE_MS hold
+  tailLightChangeRequested = false;
+  cancelTimer(TIMER_TAIL_LIGHT_CHANGE);
+  setTailLight(true);
+  if (currentBeamMode == BEAM_OFF) {
+    setBeamMode(BEAM_LOW);
+  }
+}
+
+static void detectTunnel(uint16_t sample) {
+  // Starts in daylight or low light only (the filtered class follows the
+  // drop within a sample or two), needs the car moving and something left
+  // to switch on
+  bool lightsOn = tailLightActive && currentBeamMode != BEAM_OFF;
+  bool daylight = tunnelDarkSamples ? true : brightnessLevel != DARK;
+  int baseline = tunnelDarkSamples ? tunnelBaseline : readLightLevel();
+  bool dark = (int)sample - baseline >= TUNNEL_LIGHT_RISE && classifyLightLevel(sample) != BRIGHT;
+  if (!dark || !daylight || lightsOn || !isCarMoving()) {
+    tunnelDarkSamples = 0;
+    return;
+  }
+
+  if (tunnelDarkSamples++ == 0) {
+    tunnelBaseline = baseline;
+    tunnelOnsetTime = getAdcSampleTime(ADC_SCAN_PHOTOSENSOR);
+  }
+  if (tunnelDarkSamples < TUNNEL_CONFIRM_SAMPLES) return;
+
+  tunnelDarkSamples = 0;
+  switchOnTunnelLights();
+  // Latency from the first dark sample, to tune TUNNEL_CONFIRM_SAMPLES
+  logEvent(LOG_EVENT_TUNNEL_DETECTED, (int32_t)(millis() - tunnelOnsetTime), (int32_t)sample);
+}
+
+int readLightLevel() {
+  // Filtered light level (0-1023); reading it adds no sample
+  return lightFilterState >> LIGHT_FILTER_SHIFT;
+}
+
+BrightnessLevel getBrightnessLevel() {
+  // Cached class, updated once per light sample
+  return brightnessLevel;
+}
+
 void setDRL(bool state) {
   if (drlActive != state) {
     drlActive = state;
-    digitalWrite(DRL_MOSFET_PIN, state ? RELAY_ON : RELAY_OFF);
-    Serial.print("DRL:");
-    Serial.println(state ? "1" : "0");
+    setOutput(OUTPUT_DRL, state);
   }
 }
 
 void setTailLight(bool state) {
   if (tailLightActive != state) {
     tailLightActive = state;
-    digitalWrite(TAIL_LIGHT_MOSFET_PIN, state ? RELAY_ON : RELAY_OFF);
-    // Note: ESP32 doesn't have a specific TAIL_LIGHT key, so we'll use a custom key
-    Serial.print("TAIL_LIGHT:");
-    Serial.println(state ? "1" : "0");
+    setOutput(OUTPUT_TAIL_LIGHT, state);
   }
 }
 
@@ -296,30 +289,21 @@ void setBeamMode(BeamMode mode) {
   if (currentBeamMode != mode) {
     // Cancel any pending automatic beam mode changes when manually setting
     beamModeChangeRequested = false;
+    cancelTimer(TIMER_BEAM_MODE_CHANGE);
     
     currentBeamMode = mode;
     
-    // Set low beam based on mode
-    bool lowBeamState = (mode == BEAM_LOW);
-    digitalWrite(LOW_BEAM_MOSFET_PIN, lowBeamState ? RELAY_ON : RELAY_OFF);
-    Serial.print("LOWBEAM:");
-    Serial.println(lowBeamState ? "1" : "0");
-    
-    // Set high beam based on mode
-    bool highBeamState = (mode == BEAM_HIGH);
-    digitalWrite(HIGH_BEAM_MOSFET_PIN, highBeamState ? RELAY_ON : RELAY_OFF);
-    Serial.print("HIGHBEAM:");
-    Serial.println(highBeamState ? "1" : "0");
+    // Both beams switch in the same outputs commit: no gap with both off
+    setOutput(OUTPUT_LOW_BEAM, mode == BEAM_LOW);
+    setOutput(OUTPUT_HIGH_BEAM, mode == BEAM_HIGH);
     
-    // Debug output
-    const char* modeNames[] = {"OFF", "LOW", "HIGH"};
-    Serial.print("Beam mode changed to: ");
-    Serial.println(modeNames[mode]);
+    // Debug output (one catalog entry per mode, in BeamMode order)
+    logEvent((LogEvent)(LOG_EVENT_BEAM_MODE_OFF + mode));
   }
 }
 
 JoystickDirection readJoystickDirection() {
-  int joystickValue = analogRead(JOYSTICK_Y_PIN);
+  int joystickValue = readAdcChannel(ADC_SCAN_JOYSTICK);
   joystickYValue = joystickValue; // Store for debug output
   
   if (joystickValue > JOYSTICK_UP_THRESHOLD) {
@@ -332,18 +316,10 @@ JoystickDirection readJoystickDirection() {
 }
 
 void startBeamFlash() {
-  // Start beam flashing sequence
-  if (!beamFlashInProgress) {
-    beamFlashInProgress = true;
-    beamFlashStartTime = millis();
-    beamFlashStep = 0;
-    
-    // Store current beam states
-    previousBeamMode = currentBeamMode;
-    
-    Serial.print("Beam flash started (Y=");
-    Serial.print(joystickYValue);
-    Serial.println(")");
+  // The sequence engine drives the beams and restores them when done; the
+  // beam mode itself is left alone
+  if (startSequence(SEQUENCE_PASSING_FLASH)) {
+    logEvent(LOG_EVENT_BEAM_FLASH_STARTED, joystickYValue);
   }
 }
 
@@ -352,14 +328,10 @@ void toggleBeamMode() {
   // If currently OFF, ignore joystick input
   if (currentBeamMode == BEAM_LOW) {
     setBeamMode(BEAM_HIGH);
-    Serial.print("Switched to high beam (Y=");
-    Serial.print(joystickYValue);
-    Serial.println(")");
+    logEvent(LOG_EVENT_BEAM_SWITCHED_HIGH, joystickYValue);
   } else if (currentBeamMode == BEAM_HIGH) {
     setBeamMode(BEAM_LOW);
-    Serial.print("Switched to low beam (Y=");
-    Serial.print(joystickYValue);
-    Serial.println(")");
+    logEvent(LOG_EVENT_BEAM_SWITCHED_LOW, joystickYValue);
   }
   // If BEAM_OFF, do nothing (ignore joystick input)
 }
@@ -369,95 +341,24 @@ void handleJoystick() {
   JoystickDirection direction = readJoystickDirection();
   
   // Handle joystick up (beam flashing)
-  if (direction == JOYSTICK_UP && !joystickUpPressed && (millis() - lastJoystickUpTime > JOYSTICK_DEBOUNCE_MS)) {
+  if (direction == JOYSTICK_UP && !joystickUpPressed && !isTimerArmed(TIMER_JOYSTICK_UP)) {
     joystickUpPressed = true;
-    lastJoystickUpTime = millis();
+    armTimer(TIMER_JOYSTICK_UP, JOYSTICK_DEBOUNCE_MS, nullptr);
     startBeamFlash();
   } else if (direction != JOYSTICK_UP) {
     joystickUpPressed = false;
   }
   
   // Handle joystick down (beam switching)
-  if (direction == JOYSTICK_DOWN && !joystickDownPressed && (millis() - lastJoystickDownTime > JOYSTICK_DEBOUNCE_MS)) {
+  if (direction == JOYSTICK_DOWN && !joystickDownPressed && !isTimerArmed(TIMER_JOYSTICK_DOWN)) {
     joystickDownPressed = true;
-    lastJoystickDownTime = millis();
+    armTimer(TIMER_JOYSTICK_DOWN, JOYSTICK_DEBOUNCE_MS, nullptr);
     
     // Only switch if not currently flashing
-    if (!beamFlashInProgress) {
+    if (!isSequencePlaying()) {
       toggleBeamMode();
     }
   } else if (direction != JOYSTICK_DOWN) {
     joystickDownPressed = false;
   }
 }
-
-void performBeamFlash() {
-  unsigned long elapsed = millis() - beamFlashStartTime;
-  
-  // Flash sequence: high-low-high-low (2 complete cycles)
-  // Each flash is 300ms duration with 200ms pause (relay-friendly)
-  
-  switch (beamFlashStep) {
-    case 0: // First flash - high beam
-      if (elapsed >= 0) {
-        setBeamMode(BEAM_HIGH);
-        beamFlashStep = 1;
-      }
-      break;
-      
-    case 1: // First pause
-      if (elapsed >= BEAM_FLASH_DURATION_MS) {
-        setBeamMode(BEAM_LOW);
-        beamFlashStep = 2;
-      }
-      break;
-      
-    case 2: // Second flash - low beam
-      if (elapsed >= BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS) {
-        setBeamMode(BEAM_LOW);
-        beamFlashStep = 3;
-      }
-      break;
-      
-    case 3: // Second pause
-      if (elapsed >= 2 * (BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS)) {
-        setBeamMode(BEAM_OFF);
-        beamFlashStep = 4;
-      }
-      break;
-      
-    case 4: // Third flash - high beam
-      if (elapsed >= 2 * (BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS) + BEAM_FLASH_PAUSE_MS) {
-        setBeamMode(BEAM_HIGH);
-        beamFlashStep = 5;
-      }
-      break;
-      
-    case 5: // Third pause
-      if (elapsed >= 3 * (BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS)) {
-        setBeamMode(BEAM_LOW);
-        beamFlashStep = 6;
-      }
-      break;
-      
-    case 6: // Fourth flash - low beam
-      if (elapsed >= 3 * (BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS) + BEAM_FLASH_PAUSE_MS) {
-        setBeamMode(BEAM_LOW);
-        beamFlashStep = 7;
-      }
-      break;
-      
-    case 7: // Final pause and restore
-      if (elapsed >= 4 * (BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS)) {
-        // Restore previous beam mode
-        setBeamMode(previousBeamMode);
-        
-        // End flashing sequence
-        beamFlashInProgress = false;
-        beamFlashStep = 0;
-        
-        Serial.println("Beam flash completed");
-      }
-      break;
-  }
-}
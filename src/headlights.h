@@ -3,26 +3,28 @@
 
 #include <Arduino.h>
 #include "relay_config.h"
+#include "timers.h"
+#include "events.h"
 
 // Headlight configuration
-extern const int PHOTOSENSOR_PIN;        // Photosensitive sensor DO pin
-extern const int DRL_MOSFET_PIN;         // DRL (Daytime Running Lights) MOSFET control
-extern const int TAIL_LIGHT_MOSFET_PIN;  // Tail light MOSFET control
-extern const int LOW_BEAM_MOSFET_PIN;    // Low beam headlight MOSFET control
-extern const int HIGH_BEAM_MOSFET_PIN;   // High beam headlight MOSFET control
-extern const int JOYSTICK_Y_PIN;         // Joystick Y-axis analog pin
+constexpr uint8_t PHOTOSENSOR_PIN = A0;      // A0: Photosensitive sensor DO pin (analog input)
+constexpr uint8_t DRL_MOSFET_PIN = 11;       // D11: DRL MOSFET control
+constexpr uint8_t TAIL_LIGHT_MOSFET_PIN = 7; // D7: Tail light MOSFET control
+constexpr uint8_t LOW_BEAM_MOSFET_PIN = 13;  // D13: Low beam MOSFET control
+constexpr uint8_t HIGH_BEAM_MOSFET_PIN = A2; // A2: High beam MOSFET control
+constexpr uint8_t JOYSTICK_Y_PIN = A1;       // A1: Joystick Y-axis analog pin
 
 // Timing configuration
-extern const unsigned long LIGHT_ON_DEBOUNCE_MS;   // Debounce time when turning lights ON (5 seconds)
-extern const unsigned long LIGHT_OFF_DEBOUNCE_MS;  // Debounce time when turning lights OFF (1 minute)
-extern const unsigned long DRL_TIMEOUT_MS;         // DRL timeout to avoid power competition during cranking (1 minute)
+extern unsigned long LIGHT_ON_DEBOUNCE_MS;         // Debounce time when turning lights ON (5 seconds)
+extern unsigned long LIGHT_OFF_DEBOUNCE_MS;        // Debounce time when turning lights OFF (1 minute)
+extern unsigned long DRL_TIMEOUT_MS;               // DRL timeout to avoid power competition during cranking (1 minute)
+extern const unsigned long LIGHT_READING_INTERVAL_MS; // How often light level and speed are evaluated
 
 // Light level thresholds (configurable)
 extern int LOW_LIGHT_THRESHOLD;    // Threshold for low light detection (0-1023)
 extern int DARK_THRESHOLD;         // Threshold for dark detection (0-1023)
-
-// Speed threshold
-extern const float DRL_ACTIVATION_SPEED_THRESHOLD;  // Speed threshold for DRL activation
+extern const int LIGHT_HYSTERESIS;        // Hysteresis band around both thresholds
+extern const uint8_t LIGHT_FILTER_SHIFT;  // Light level EMA weight: 1 / 2^shift per sample
 
 // Brightness level enum
 enum BrightnessLevel {
@@ -45,21 +47,17 @@ enum JoystickDirection {
   JOYSTICK_DOWN     // Down direction (beam switching)
 };
 
-// Headlight state variables
-extern bool drlActive;
-extern bool tailLightActive;
-extern BeamMode currentBeamMode;
-
 // Headlight functions
 void setupHeadlights();
 void handleHeadlights();
+void onHeadlightEvent(const Event& event);   // Brightness class or moving state changed
+void handleBeamControl();
+bool isJoystickSampleNew();             // Scheduler ready check: the ADC scanner has a new joystick result
 void calculateDesiredLightStates();
-void applyLightStateChanges();
-void checkLightChange(bool desired, bool current, bool& changeRequested, unsigned long& changeRequestTime, bool& changeToOn, const char* lightName);
-void applyIndividualLightChange(bool& changeRequested, unsigned long& changeRequestTime, bool& changeToOn, bool& currentState, void (*setFunction)(bool), const char* lightName);
-bool isCarMoving();
-int readLightLevel();
-BrightnessLevel getBrightnessLevel();
+void checkLightChange(bool desired, bool current, bool& changeRequested, bool& changeToOn, uint8_t timer, TimerCallback apply);
+int readLightLevel();                   // Filtered light level
+BrightnessLevel classifyLightLevel(int lightLevel);
+BrightnessLevel getBrightnessLevel();   // Cached class of the filtered level
 void setDRL(bool state);
 void setTailLight(bool state);
 void setBeamMode(BeamMode mode);
@@ -67,6 +65,5 @@ void handleJoystick();
 JoystickDirection readJoystickDirection();
 void startBeamFlash();
 void toggleBeamMode();
-void performBeamFlash();
 
 #endif
@@ -1,84 +1,207 @@
 #include "horn.h"
+#include "inputs.h"
+#include "log.h"
+#include "outputs.h"
+#include "fastpin.h"
+#include "timers.h"
+#include "events.h"
+
+// Horn pins, resolved at compile time. The relay is claimed by the ISR in
+// fast path mode and written directly; otherwise it goes through the outputs
+// commit like every other relay.
+typedef RelayPin<HORN_MOSFET_PIN> HornRelay;
+typedef FastPin<HORN_BUTTON_PIN> HornButton;
 
 // Horn configuration
-const int HORN_BUTTON_PIN = 6; // D6: Capacitive touch button for horn activation
-const int HORN_MOSFET_PIN = 12; // D12: Horn 12V relay control
-const unsigned long HORN_BUTTON_DEBOUNCE_MS = 5;
-const unsigned long HORN_MAX_DURATION_MS = 5000; // Maximum 5 seconds continuous horn
-
-// Horn state variables
-static bool hornIsActive = false;
-static bool hornButtonPressed = false;
-static int hornLastButtonState = HIGH;
-static unsigned long hornLastDebounceTime = 0;
-static unsigned long hornStartTime = 0;
+unsigned long HORN_MAX_DURATION_MS = 5000;       // Maximum 5 seconds continuous horn
+const unsigned long HORN_CUTOFF_CHECK_MS = 10;   // Fast path: how often the cutoff is checked
 
-void setupHorn() {
-  // Setup horn relay control
-  pinMode(HORN_MOSFET_PIN, OUTPUT);
-  digitalWrite(HORN_MOSFET_PIN, RELAY_OFF); // Ensure horn is off initially
+// Horn state variables (shared with the pin-change ISR in fast path mode)
+static volatile bool hornIsActive = false;
+static volatile unsigned long hornStartTime = 0;
+
+// Switch time: from entering the touch handler to driving the relay, in
+// micros() steps (4 us). It is not the touch-to-relay latency: interrupt
+// entry, other ISRs and noInterrupts() sections delay the handler without
+// showing up here. test/simavr measures the real latency end to end
+// (latency.touch_to_horn_us).
+static volatile unsigned long hornSwitchLastMicros = 0;
+static volatile unsigned long hornSwitchMaxMicros = 0;
+
+static inline void writeHornRelay(bool on) {
+#if HORN_FAST_PATH
+  HornRelay::set(on);
+#else
+  setOutput(OUTPUT_HORN, on);
+#endif
+}
+
+#if HORN_FAST_PATH
+static volatile bool hornLockedOut = false; // Set by the safety cutoff until the button is released
+static bool hornReportedActive = false;     // Last state logged from the loop
+
+// Priority lane: runs on every level change of the horn button, so the relay
+// follows the touch without waiting for the loop, serial output or other
+// modules. The capacitive sensor drives a clean logic level, so no debouncing
+// is needed here.
+static void onHornButtonChange() {
+  unsigned long detected = micros();
+  bool touched = HornButton::read();
+
+  if (touched && !hornIsActive && !hornLockedOut) {
+    HornRelay::on();
+    hornIsActive = true;
+    hornStartTime = millis();
+    postEventFromIsr(EVENT_HORN_SWITCHED, true);
+
+    unsigned long switchMicros = micros() - detected;
+    hornSwitchLastMicros = switchMicros;
+    if (switchMicros > hornSwitchMaxMicros) hornSwitchMaxMicros = switchMicros;
+  } else if (!touched) {
+    HornRelay::off();
+    if (hornIsActive) postEventFromIsr(EVENT_HORN_SWITCHED, false);
+    hornIsActive = false;
+    hornLockedOut = false;
+  }
+}
+
+#if defined(__AVR__)
+ISR(PCINT2_vect) {
+  // PCINT16-23 (D0-D7); only the horn button is enabled in PCMSK2
+  onHornButtonChange();
+}
+#endif
+#endif
 
+void setupHorn() {
   // Setup capacitive touch button for horn
   // Capacitive touch button: GND, VCC, I/O pins
   // I/O pin connected to Arduino input, VCC to +5V, GND to ground
-  pinMode(HORN_BUTTON_PIN, INPUT); // No internal pull-up, capacitive button has its own pull-up
-  
-  // Read initial button state
-  hornLastButtonState = digitalRead(HORN_BUTTON_PIN);
+  HornButton::input(); // No internal pull-up, capacitive button has its own pull-up
+
+#if HORN_FAST_PATH
+  // A button already held at power-up must be released before the horn sounds
+  hornLockedOut = HornButton::read();
+  claimOutputs(OUTPUT_HORN);
+
+#if defined(__AVR__)
+  // Enable the pin-change interrupt for the horn button only
+  *digitalPinToPCMSK(HORN_BUTTON_PIN) |= _BV(digitalPinToPCMSKbit(HORN_BUTTON_PIN));
+  PCIFR = _BV(digitalPinToPCICRbit(HORN_BUTTON_PIN));
+  PCICR |= _BV(digitalPinToPCICRbit(HORN_BUTTON_PIN));
+#else
+  attachPinChangeInterrupt(HORN_BUTTON_PIN, onHornButtonChange);
+#endif
+#endif
+}
+
+static void onHornTimeout() {
+  // Safety timeout - prevent horn from running too long
+  noInterrupts();
+  unsigned long onMs = millis() - hornStartTime;
+  interrupts();
+#if HORN_FAST_PATH
+  noInterrupts();
+  hornLockedOut = true;
+  interrupts();
+#endif
+  deactivateHorn();
+  logEvent(LOG_EVENT_HORN_TIMEOUT, (int32_t)onMs);
 }
 
-void handleHorn() {
-  // Read capacitive touch button state
-  int buttonState = digitalRead(HORN_BUTTON_PIN);
+#if HORN_FAST_PATH
+void checkHornCutoff() {
+  // Polled from the ISR's own state rather than armed from EVENT_HORN_SWITCHED:
+  // an event lost to a full queue must not leave the relay on with no cutoff
+  noInterrupts();
+  bool expired = hornIsActive && millis() - hornStartTime >= HORN_MAX_DURATION_MS;
+  interrupts();
+  if (expired) onHornTimeout();
+}
 
-  // If the button state changed, reset the debouncing timer
-  if (buttonState != hornLastButtonState) {
-    hornLastDebounceTime = millis();
-  }
+void onHornEvent(const Event& event) {
+  // The ISR switches the relay and posts EVENT_HORN_SWITCHED; the loop logs
+  if (event.type != EVENT_HORN_SWITCHED) return;
+  bool active = event.arg;
+  noInterrupts();
+  unsigned long switchMicros = hornSwitchLastMicros;
+  unsigned long switchMaxMicros = hornSwitchMaxMicros;
+  interrupts();
 
-  // Check if button state has been stable long enough
-  if ((millis() - hornLastDebounceTime) > HORN_BUTTON_DEBOUNCE_MS) {
-    // Capacitive touch button reads HIGH when touched, LOW when not touched
-    bool buttonPressed = (buttonState == HIGH);
-    
-    if (buttonPressed && !hornButtonPressed) {
-      // Button just pressed - activate horn
-      activateHorn();
-      hornButtonPressed = true;
-    } else if (!buttonPressed && hornButtonPressed) {
-      // Button just released - deactivate horn
-      deactivateHorn();
-      hornButtonPressed = false;
+  // Logging happens here, never in the ISR
+  if (active != hornReportedActive) {
+    hornReportedActive = active;
+    if (active) {
+      logEvent(LOG_EVENT_HORN_ON_TIMED, (int32_t)switchMicros, (int32_t)switchMaxMicros);
+    } else {
+      logEvent(LOG_EVENT_HORN_OFF);
     }
   }
+}
+#else
+void onHornEvent(const Event& event) {
+  if (event.type != EVENT_BUTTON_EDGE) return;
 
-  // Safety timeout - prevent horn from running too long
-  if (hornIsActive && (millis() - hornStartTime) >= HORN_MAX_DURATION_MS) {
+  // Debounced button edges from the shared input debouncer
+  // Capacitive touch button reads HIGH when touched, LOW when not touched
+  uint8_t mask = inputMask(HORN_BUTTON_PIN);
+  if (takeInputPresses(mask)) {
+    // Button just pressed - activate horn
+    unsigned long detected = micros();
+    activateHorn();
+    hornSwitchLastMicros = micros() - detected;
+    if (hornSwitchLastMicros > hornSwitchMaxMicros) hornSwitchMaxMicros = hornSwitchLastMicros;
+  }
+  if (takeInputReleases(mask)) {
+    // Button just released - deactivate horn
     deactivateHorn();
-    Serial.println("Horn turned off - maximum duration reached (5 seconds)");
   }
-
-  // Save the reading for next iteration
-  hornLastButtonState = buttonState;
 }
+#endif
 
 bool isHornActive() {
   return hornIsActive;
 }
 
 void activateHorn() {
-  if (!hornIsActive) {
+  noInterrupts();
+  bool wasActive = hornIsActive;
+  if (!wasActive) {
     hornIsActive = true;
     hornStartTime = millis();
-    digitalWrite(HORN_MOSFET_PIN, RELAY_ON);
-    Serial.println("Horn activated!");
+    writeHornRelay(true);
   }
+  interrupts();
+#if !HORN_FAST_PATH
+  if (!wasActive) {
+    armTimer(TIMER_HORN_MAX_DURATION, HORN_MAX_DURATION_MS, onHornTimeout);
+    logEvent(LOG_EVENT_HORN_ON);
+  }
+#endif
 }
 
 void deactivateHorn() {
-  if (hornIsActive) {
+  noInterrupts();
+  bool wasActive = hornIsActive;
+  if (wasActive) {
     hornIsActive = false;
-    digitalWrite(HORN_MOSFET_PIN, RELAY_OFF);
-    Serial.println("Horn deactivated!");
+    writeHornRelay(false);
+  }
+  interrupts();
+#if HORN_FAST_PATH
+  // Switched off from the loop (safety cutoff): reported like the ISR does
+  if (wasActive) postEvent(EVENT_HORN_SWITCHED, false);
+#else
+  if (wasActive) {
+    cancelTimer(TIMER_HORN_MAX_DURATION);
+    logEvent(LOG_EVENT_HORN_OFF);
   }
+#endif
+}
+
+unsigned long getHornSwitchMaxMicros() {
+  noInterrupts();
+  unsigned long switchMicros = hornSwitchMaxMicros;
+  interrupts();
+  return switchMicros;
 }
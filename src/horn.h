@@ -3,18 +3,29 @@
 
 #include <Arduino.h>
 #include "relay_config.h"
+#include "events.h"
+
+// Horn fast path: 1 = pin-change interrupt on the button drives the relay
+// directly, 0 = button debounced by the shared input debouncer
+#ifndef HORN_FAST_PATH
+#define HORN_FAST_PATH 1
+#endif
 
 // Horn configuration
-extern const int HORN_BUTTON_PIN;
-extern const int HORN_MOSFET_PIN;
-extern const unsigned long HORN_BUTTON_DEBOUNCE_MS;
-extern const unsigned long HORN_MAX_DURATION_MS;
+constexpr uint8_t HORN_BUTTON_PIN = 6;  // D6: Capacitive touch button for horn activation (PCINT22)
+constexpr uint8_t HORN_MOSFET_PIN = 12; // D12: Horn 12V relay control
+extern unsigned long HORN_MAX_DURATION_MS;
+extern const unsigned long HORN_CUTOFF_CHECK_MS;
 
 // Horn functions
 void setupHorn();
-void handleHorn();
+void onHornEvent(const Event& event);   // Fast path: EVENT_HORN_SWITCHED, otherwise button edges
+#if HORN_FAST_PATH
+void checkHornCutoff();                 // Safety cutoff for the relay the ISR switched on
+#endif
 bool isHornActive();
 void activateHorn();
 void deactivateHorn();
+unsigned long getHornSwitchMaxMicros();   // Longest handler-entry-to-relay time (not the latency, see horn.cpp)
 
 #endif
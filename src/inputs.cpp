@@ -0,0 +1,80 @@
+#include "inputs.h"
+#include "events.h"
+#include "horn.h"
+#include "reverse.h"
+
+// Input configuration
+const unsigned long INPUT_SAMPLE_INTERVAL_MS = 5; // Sample PORTD every 5ms
+const uint8_t INPUT_DEBOUNCE_SAMPLES = 4;        // 2-bit counters: 4 equal samples (15-20ms)
+
+// Pins that report edges. The rest of PORTD is the UART (D0/D1) and outputs
+// (D4 camera, D7 tail lights); they are debounced too but never post events.
+const uint8_t INPUT_EDGE_MASK = inputMask(REVERSE_GEAR_PIN) | inputMask(CAMERA_BUTTON_PIN) |
+                                inputMask(HORN_BUTTON_PIN);
+
+// Debounce state: one bit per pin
+static uint8_t debouncedState = 0;
+static uint8_t counterLow = 0xFF;   // Vertical counter bit 0
+static uint8_t counterHigh = 0xFF;  // Vertical counter bit 1
+static uint8_t pressedEdges = 0;
+static uint8_t releasedEdges = 0;
+
+static inline uint8_t readInputPort() {
+#if defined(__AVR__)
+  return PIND;
+#else
+  uint8_t port = 0;
+  for (uint8_t pin = 0; pin < 8; pin++) {
+    if (digitalRead(pin) == HIGH) port |= inputMask(pin);
+  }
+  return port;
+#endif
+}
+
+void setupInputs() {
+  // Start from the current levels so nothing reports a spurious edge
+  debouncedState = readInputPort();
+  counterLow = 0xFF;
+  counterHigh = 0xFF;
+  pressedEdges = 0;
+  releasedEdges = 0;
+}
+
+void sampleInputs() {
+  // Bits that differ from the debounced state count down; equal bits reset
+  uint8_t changed = debouncedState ^ readInputPort();
+  counterLow = ~(counterLow & changed);
+  counterHigh = counterLow ^ (counterHigh & changed);
+
+  // Counter rolled over: the bit has differed for 4 samples in a row
+  changed &= counterLow & counterHigh;
+  debouncedState ^= changed;
+  changed &= INPUT_EDGE_MASK;
+  pressedEdges |= debouncedState & changed;
+  releasedEdges |= ~debouncedState & changed;
+
+  // Subscribers take their own pins' edges with takeInputPresses/Releases()
+  if (changed) {
+    postEvent(EVENT_BUTTON_EDGE, debouncedState & changed, (uint8_t)(~debouncedState & changed));
+  }
+}
+
+uint8_t getDebouncedInputs() {
+  return debouncedState;
+}
+
+uint8_t peekInputEdges() {
+  return pressedEdges | releasedEdges;
+}
+
+uint8_t takeInputPresses(uint8_t mask) {
+  uint8_t edges = pressedEdges & mask;
+  pressedEdges &= ~mask;
+  return edges;
+}
+
+uint8_t takeInputReleases(uint8_t mask) {
+  uint8_t edges = releasedEdges & mask;
+  releasedEdges &= ~mask;
+  return edges;
+}
@@ -0,0 +1,27 @@
+#ifndef INPUTS_H
+#define INPUTS_H
+
+#include <Arduino.h>
+
+// Digital input debouncing for the PORTD pins (D0-D7).
+// All eight bits are sampled with one port read per tick and debounced in
+// parallel by 2-bit vertical counters: a bit changes state after it has
+// differed from the debounced state for INPUT_DEBOUNCE_SAMPLES samples in a row.
+extern const unsigned long INPUT_SAMPLE_INTERVAL_MS;
+extern const uint8_t INPUT_DEBOUNCE_SAMPLES;
+extern const uint8_t INPUT_EDGE_MASK;   // Pins whose edges are reported
+
+// Bit for a PORTD pin in the input masks
+constexpr uint8_t inputMask(uint8_t pin) {
+  return (uint8_t)(1 << pin);
+}
+
+// Input functions
+void setupInputs();
+void sampleInputs();
+uint8_t getDebouncedInputs();
+uint8_t peekInputEdges();                  // Pending press/release bits, not consumed
+uint8_t takeInputPresses(uint8_t mask);    // Debounced LOW -> HIGH edges since last call
+uint8_t takeInputReleases(uint8_t mask);   // Debounced HIGH -> LOW edges since last call
+
+#endif
@@ -0,0 +1,197 @@
+#include "log.h"
+#include "telemetry.h"
+
+// Log configuration
+const uint8_t LOG_QUEUE_SIZE = 64;  // Power of two; ~20 messages without arguments
+
+// Message texts in flash. Texts above LOG_LEVEL are never queued, so they
+// are compiled as empty strings.
+#define LOG_TEXT_ERROR(text) text
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_TEXT_WARN(text) text
+#else
+#define LOG_TEXT_WARN(text) ""
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_TEXT_INFO(text) text
+#else
+#define LOG_TEXT_INFO(text) ""
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_TEXT_DEBUG(text) text
+#else
+#define LOG_TEXT_DEBUG(text) ""
+#endif
+
+#define LOG_EVENT_TEXT(name, level, text) static const char LOG_TEXT_##name[] PROGMEM = LOG_TEXT_##level(text);
+LOG_EVENTS(LOG_EVENT_TEXT)
+#undef LOG_EVENT_TEXT
+
+static const char* const LOG_TEXTS[] PROGMEM = {
+#define LOG_EVENT_TEXT_ENTRY(name, level, text) LOG_TEXT_##name,
+  LOG_EVENTS(LOG_EVENT_TEXT_ENTRY)
+#undef LOG_EVENT_TEXT_ENTRY
+};
+
+// Queued messages: event ID, argument count, arguments (little-endian int32)
+static uint8_t logQueue[LOG_QUEUE_SIZE];
+static uint8_t queueHead = 0;
+static uint8_t queueTail = 0;
+static uint8_t queueUsed = 0;
+static unsigned long droppedMessages = 0;
+static unsigned long reportedDropped = 0;
+
+// Message being written to Serial
+static bool lineOpen = false;
+static PGM_P lineText = nullptr;    // Next character of the text, in flash
+static int32_t lineArgs[2];
+static uint8_t lineArgIndex = 0;
+static char lineDigits[11];         // Formatted argument, least significant digit first
+static uint8_t lineDigitCount = 0;
+static uint8_t lineEndPending = 0;  // Bytes of "\r\n" still to write
+static bool debugLineOpen = false;  // Another module is writing a line piecewise
+
+static uint8_t popByte() {
+  uint8_t value = logQueue[queueTail];
+  queueTail = (queueTail + 1) & (LOG_QUEUE_SIZE - 1);
+  queueUsed--;
+  return value;
+}
+
+static void pushByte(uint8_t value) {
+  logQueue[queueHead] = value;
+  queueHead = (queueHead + 1) & (LOG_QUEUE_SIZE - 1);
+  queueUsed++;
+}
+
+static void dropOldest() {
+  popByte();                      // Event ID
+  uint8_t argCount = popByte();
+  for (uint8_t i = 0; i < argCount * 4; i++) popByte();
+  droppedMessages++;
+}
+
+void queueLogEvent(LogEvent event, uint8_t argCount, int32_t arg0, int32_t arg1) {
+  // Not for use from ISRs: the queue is only touched from loop()
+  uint8_t size = 2 + argCount * 4;
+  while (LOG_QUEUE_SIZE - queueUsed < size) {
+    dropOldest();
+  }
+
+  pushByte(event);
+  pushByte(argCount);
+  int32_t args[2] = {arg0, arg1};
+  for (uint8_t i = 0; i < argCount; i++) {
+    for (uint8_t shift = 0; shift < 32; shift += 8) {
+      pushByte((uint8_t)(args[i] >> shift));
+    }
+  }
+}
+
+static void openLine(LogEvent event) {
+  lineText = (PGM_P)pgm_read_ptr(&LOG_TEXTS[event]);
+  lineArgIndex = 0;
+  lineDigitCount = 0;
+  lineEndPending = 2;
+  lineOpen = true;
+}
+
+static bool startNextLine() {
+  if (droppedMessages != reportedDropped && LOG_EVENT_LEVELS[LOG_EVENT_LOG_DROPPED] <= LOG_LEVEL) {
+    // Report drops ahead of the surviving messages
+    reportedDropped = droppedMessages;
+    lineArgs[0] = (int32_t)droppedMessages;
+    openLine(LOG_EVENT_LOG_DROPPED);
+    return true;
+  }
+  if (queueUsed == 0) return false;
+
+  LogEvent event = (LogEvent)popByte();
+  uint8_t argCount = popByte();
+  for (uint8_t i = 0; i < argCount; i++) {
+    uint32_t value = 0;
+    for (uint8_t shift = 0; shift < 32; shift += 8) {
+      value |= (uint32_t)popByte() << shift;
+    }
+    lineArgs[i] = (int32_t)value;
+  }
+  openLine(event);
+  return true;
+}
+
+static void formatArgument(bool zeroPad) {
+  int32_t value = lineArgIndex < 2 ? lineArgs[lineArgIndex++] : 0;
+  uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+  do {
+    lineDigits[lineDigitCount++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  while (zeroPad && lineDigitCount < 6) lineDigits[lineDigitCount++] = '0';
+  if (value < 0) lineDigits[lineDigitCount++] = '-';
+}
+
+void drainLog() {
+  if (!lineOpen) {
+    // State telemetry goes first, and a held debug line is finished first
+    if (isTelemetryPending() || debugLineOpen) return;
+    if (!startNextLine()) return;
+  }
+
+  int room = Serial.availableForWrite();
+  while (room > 0) {
+    if (lineDigitCount > 0) {
+      Serial.write((uint8_t)lineDigits[--lineDigitCount]);
+      room--;
+      continue;
+    }
+
+    char c = (char)pgm_read_byte(lineText);
+    if (c == '#' || c == '~') {
+      lineText++;
+      formatArgument(c == '~');
+      continue;
+    }
+    if (c != '\0') {
+      lineText++;
+      Serial.write((uint8_t)c);
+      room--;
+      continue;
+    }
+
+    // End of text: finish the line
+    Serial.write((uint8_t)(lineEndPending == 2 ? '\r' : '\n'));
+    room--;
+    if (--lineEndPending == 0) {
+      lineOpen = false;
+      break;
+    }
+  }
+}
+
+bool isLogPending() {
+  if (lineOpen) return Serial.availableForWrite() > 0;
+  return queueUsed > 0 && !isTelemetryPending() && !debugLineOpen;
+}
+
+bool isLogLineOpen() {
+  return lineOpen || debugLineOpen;
+}
+
+bool canWriteDebugLine(uint8_t length) {
+  return !lineOpen && !debugLineOpen && queueUsed == 0 && !isTelemetryPending() &&
+         Serial.availableForWrite() >= length;
+}
+
+bool openDebugLine(uint8_t length) {
+  if (!canWriteDebugLine(length)) return false;
+  debugLineOpen = true;
+  return true;
+}
+
+void closeDebugLine() {
+  debugLineOpen = false;
+}
+
+unsigned long getLogDropped() {
+  return droppedMessages;
+}
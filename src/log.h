@@ -0,0 +1,66 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include "log_events.h"
+
+// Non-blocking serial log.
+// Messages are numeric event IDs (see log_events.h) with up to two integer
+// arguments, queued in a small ring and rendered from flash by drainLog()
+// only as fast as the hardware TX buffer has room, so loop() never waits on
+// the UART. When the ring is full the oldest messages are dropped and
+// counted. State telemetry has priority: a new log line is not started while
+// telemetry is pending, and telemetry never starts in the middle of a line.
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// Compile-time log level: messages above it are removed along with their text
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+enum LogEvent : uint8_t {
+#define LOG_EVENT_ID(name, level, text) LOG_EVENT_##name,
+  LOG_EVENTS(LOG_EVENT_ID)
+#undef LOG_EVENT_ID
+  LOG_EVENT_COUNT
+};
+
+// Level of each event, for compile-time filtering in logEvent()
+constexpr uint8_t LOG_EVENT_LEVELS[] = {
+#define LOG_EVENT_LEVEL(name, level, text) LOG_LEVEL_##level,
+  LOG_EVENTS(LOG_EVENT_LEVEL)
+#undef LOG_EVENT_LEVEL
+};
+
+// Log configuration
+extern const uint8_t LOG_QUEUE_SIZE;  // Bytes; a message takes 2 + 4 per argument
+
+// Log functions
+void queueLogEvent(LogEvent event, uint8_t argCount, int32_t arg0, int32_t arg1);
+void drainLog();
+bool isLogPending();                       // Scheduler ready check: drainLog() has something it can write
+bool isLogLineOpen();                      // A message or a held debug line is partly written to Serial
+bool canWriteDebugLine(uint8_t length);    // Room for a whole debug line, nothing more urgent waiting
+bool openDebugLine(uint8_t length);        // canWriteDebugLine(), then holds log and telemetry off Serial
+void closeDebugLine();                     // so the line can be written over several passes
+unsigned long getLogDropped();
+
+// Queue a message if its level is compiled in (the check folds away at compile time)
+inline void logEvent(LogEvent event) {
+  if (LOG_EVENT_LEVELS[event] <= LOG_LEVEL) queueLogEvent(event, 0, 0, 0);
+}
+
+inline void logEvent(LogEvent event, int32_t arg0) {
+  if (LOG_EVENT_LEVELS[event] <= LOG_LEVEL) queueLogEvent(event, 1, arg0, 0);
+}
+
+inline void logEvent(LogEvent event, int32_t arg0, int32_t arg1) {
+  if (LOG_EVENT_LEVELS[event] <= LOG_LEVEL) queueLogEvent(event, 2, arg0, arg1);
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LOG_EVENTS_H
+#define LOG_EVENTS_H
+
+// Catalog of log messages: X(name, level, text).
+// Each message is queued as its numeric ID plus arguments and rendered from
+// flash when the serial link has room. In the text, '#' prints the next
+// argument in decimal and '~' prints it as six zero-padded digits.
+// BEAM_MODE_OFF/LOW/HIGH must stay in BeamMode order.
+#define LOG_EVENTS(X) \
+  X(SYSTEM_STARTING,         INFO,  "Car Accessories System Starting...") \
+  X(REVERSE_READY,           INFO,  "Reverse gear and camera module initialized") \
+  X(HORN_READY,              INFO,  "Horn module initialized") \
+  X(GPS_READY,               INFO,  "GPS module initialized") \
+  X(HEADLIGHTS_READY,        INFO,  "Headlight system initialized") \
+  X(SYSTEM_READY,            INFO,  "System ready!") \
+  X(GPS_CONFIGURED,          INFO,  "GPS configured: RMC+GGA every # ms, # baud") \
+  X(GPS_NO_UBX,              WARN,  "GPS not responding to UBX, using receiver defaults") \
+  X(GPS_RX_OVERFLOW,         WARN,  "GPS RX overflow, bytes dropped: #") \
+  X(GPS_AID_NONE,            INFO,  "GPS aiding: no saved fix, cold start") \
+  X(GPS_AID_SENT,            INFO,  "GPS aiding with last fix from ~ ~ UTC (ddmmyy hhmmss)") \
+  X(CAMERA_ON_BUTTON,        INFO,  "Camera activated by capacitive touch button!") \
+  X(CAMERA_OFF_MANUAL,       INFO,  "Camera turned off - manual timeout (# ms)") \
+  X(CAMERA_OFF_AUTO,         INFO,  "Camera turned off - auto timeout (# ms)") \
+  X(CAMERA_ON_REVERSE,       INFO,  "Camera activated by reverse gear!") \
+  X(CAMERA_ON_REVERSE_AGAIN, INFO,  "Camera reactivated by reverse gear (was counting down)!") \
+  X(CAMERA_COUNTDOWN,        INFO,  "Reverse gear disengaged - camera will turn off in # ms") \
+  X(HORN_ON,                 INFO,  "Horn activated!") \
+  X(HORN_ON_TIMED,           INFO,  "Horn activated! (switched in # us, max # us)") \
+  X(HORN_OFF,                INFO,  "Horn deactivated!") \
+  X(HORN_TIMEOUT,            INFO,  "Horn turned off - maximum duration reached (on for # ms)") \
+  X(BEAM_MODE_OFF,           INFO,  "Beam mode changed to: OFF") \
+  X(BEAM_MODE_LOW,           INFO,  "Beam mode changed to: LOW") \
+  X(BEAM_MODE_HIGH,          INFO,  "Beam mode changed to: HIGH") \
+  X(BEAM_FLASH_STARTED,      DEBUG, "Beam flash started (Y=#)") \
+  X(BEAM_SWITCHED_HIGH,      DEBUG, "Switched to high beam (Y=#)") \
+  X(BEAM_SWITCHED_LOW,       DEBUG, "Switched to low beam (Y=#)") \
+  X(SEQUENCE_DONE,           DEBUG, "Sequence # completed in # ms") \
+  X(TUNNEL_DETECTED,         INFO,  "Tunnel detected: low beam on # ms after the first dark sample (light level #)") \
+  X(BRIGHTNESS_CHANGED,      DEBUG, "Brightness class # (light level #)") \
+  X(EVENTS_DROPPED,          WARN,  "Event queue full, events dropped: #") \
+  X(LOG_DROPPED,             WARN,  "Log queue full, messages dropped: #")
+
+#endif
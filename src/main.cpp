@@ -1,46 +1,122 @@
 #include <Arduino.h>
+#include "adc.h"
+#include "commands.h"
+#include "events.h"
 #include "reverse.h"
 #include "horn.h"
 #include "gps.h"
+#include "gps_aid.h"
 #include "headlights.h"
+#include "inputs.h"
+#include "log.h"
+#include "memstat.h"
+#include "outputs.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "sequence.h"
+#include "telemetry.h"
+#include "timers.h"
+#include "trace.h"
+
+// Task table: each module runs at its own cadence instead of a fixed 10ms loop.
+// Deadline is the release-to-start latency tolerated before a miss is counted.
+static const SchedulerTask tasks[] = {
+  // name        run                ready                 period (ms)                    deadline (ms) priority
+  {"inputs",     sampleInputs,      nullptr,              INPUT_SAMPLE_INTERVAL_MS,      1,            0},
+  {"events",     dispatchEvents,    isEventPending,       0,                             1,            1},
+  {"timers",     runTimers,         isTimerDue,           0,                             2,            2},
+  {"joystick",   handleBeamControl, isJoystickSampleNew,  0,                             2,            3},
+  {"sequence",   handleSequences,   isSequenceFinished,   0,                             10,           4},
+  {"reverse",    handleReverse,     isReverseGearPending, 0,                             1,            5},
+  {"gps",        handleGPS,         isGPSDataWaiting,     0,                             5,            6},
+  {"telemetry",  flushTelemetry,    nullptr,              TELEMETRY_INTERVAL_MS,         10,           7},
+  {"gpsReport",  sendGPSData,       nullptr,              GPS_NAV_INTERVAL_MS,           50,           8},
+  {"headlights", handleHeadlights,  nullptr,              LIGHT_READING_INTERVAL_MS,     50,           9},
+  {"log",        drainLog,          isLogPending,         0,                             10,           10},
+  {"commands",   handleCommands,    isCommandPending,     0,                             10,           11},
+  {"memory",     reportMemory,      isMemoryReportDue,    0,                             100,          12},
+  {"gpsSave",    writeSavedFix,     isSavedFixPending,    0,                             100,          13},
+#if HORN_FAST_PATH
+  {"hornCutoff", checkHornCutoff,   nullptr,              HORN_CUTOFF_CHECK_MS,          5,            14},
+#endif
+#if TRACE_RECORD
+  {"trace",      recordTrace,       nullptr,              TRACE_SAMPLE_INTERVAL_MS,      5,            15},
+#endif
+};
+static_assert(sizeof(tasks) / sizeof(tasks[0]) <= SCHEDULER_MAX_TASKS,
+              "task table larger than SCHEDULER_MAX_TASKS: raise it in scheduler.h");
+
+// Event subscribers, called in table order for each event of their type
+static const EventSubscriber subscribers[] = {
+  // event                   handler
+  {EVENT_BUTTON_EDGE,        onHornEvent},
+  {EVENT_BUTTON_EDGE,        onCameraEvent},
+  {EVENT_HORN_SWITCHED,      onHornEvent},
+  {EVENT_REVERSE_CHANGED,    onCameraEvent},
+  {EVENT_BRIGHTNESS_CHANGED, onHeadlightEvent},
+  {EVENT_SPEED_CROSSED,      onHeadlightEvent},
+  {EVENT_GPS_FIX,            onGpsFixEvent},
+};
 
 void setup() {
   // Initialize serial communication for debugging
   Serial.begin(115200);
-  Serial.println("Car Accessories System Starting...");
+  logEvent(LOG_EVENT_SYSTEM_STARTING);
+  
+  // Initialize telemetry first: the other modules publish their initial state
+  setupTelemetry();
+  setupCommands();
+  
+  // All relays OFF before any module runs; modules switch them via the shadow
+  setupOutputs();
+  setupSequences();
+  
+  // Timeout slots cleared before any module arms one
+  setupTimers();
+  
+  // Event bus: modules post from their setup on
+  setupEvents(subscribers, sizeof(subscribers) / sizeof(subscribers[0]));
   
   // Initialize reverse gear and camera module
   setupReverse();
-  Serial.println("Reverse gear and camera module initialized");
+  logEvent(LOG_EVENT_REVERSE_READY);
   
   // Initialize horn module
   setupHorn();
-  Serial.println("Horn module initialized");
+  logEvent(LOG_EVENT_HORN_READY);
   
   // Initialize GPS module
   setupGPS();
-  Serial.println("GPS module initialized"); 
+  setupGPSAiding();
+  logEvent(LOG_EVENT_GPS_READY);
   
-  // Initialize headlight system
+  // Initialize headlight system (photosensor and joystick come from the ADC scanner)
+  setupAdcScanner();
   setupHeadlights();
-  Serial.println("Headlight system initialized");
+  logEvent(LOG_EVENT_HEADLIGHTS_READY);
   
-  Serial.println("System ready!");
-}
-
-void loop() {
-  // Handle reverse gear detection, camera activation, and camera controls
-  handleReverse();
-  
-  // Handle horn control
-  handleHorn();
+  // Initialize the shared input debouncer once all input pins are configured
+  setupInputs();
   
-  // Handle GPS data collection and transmission
-  handleGPS();
+#if TRACE_RECORD
+  // Raw inputs go out as TRC: lines from now on, for replay on the host
+  setupTrace();
+#endif
   
-  // Handle headlight control
-  handleHeadlights();
+  // Start the task scheduler
+  setupScheduler(tasks, sizeof(tasks) / sizeof(tasks[0]));
   
-  // Small delay to prevent overwhelming the system
-  delay(10);
+  logEvent(LOG_EVENT_SYSTEM_READY);
+}
+
+void loop() {
+#if PROFILER
+  profileLoopPass();
+#endif
+
+  // Run the most urgent due task; modules no longer wait behind a fixed delay
+  runScheduler();
+
+  // Apply the outputs that task changed, all at once
+  commitOutputs();
 }
@@ -0,0 +1,103 @@
+#include "memstat.h"
+#include "log.h"
+
+// Memory statistics configuration
+const char MEMORY_REPORT_REQUEST = 'M';
+const uint8_t MEMSTAT_CANARY = 0xC5;
+
+static const uint8_t REPORT_LINE_MAX = 32;   // "MEM:2048,2048,2048,2048,2048\r\n"
+
+static bool reportRequested = false;
+
+#if defined(__AVR__)
+// From the linker script and avr-libc's malloc
+extern uint8_t __heap_start;
+extern char* __brkval;
+
+// Runs from .init3: after the stack pointer is set and r1 cleared, before
+// .data/.bss are initialized and before any call has touched the stack.
+// Naked, so it must not call anything or keep locals on the stack.
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack() {
+  for (uint8_t* p = &__heap_start; p <= (uint8_t*)RAMEND; p++) {
+    *p = MEMSTAT_CANARY;
+  }
+}
+
+static uint8_t* heapEnd() {
+  return __brkval ? (uint8_t*)__brkval : &__heap_start;
+}
+
+static uint8_t* stackPointer() {
+  return (uint8_t*)SP;
+}
+#endif
+
+void requestMemoryReport() {
+  reportRequested = true;
+}
+
+bool isMemoryReportDue() {
+  return reportRequested;
+}
+
+size_t getStaticRamBytes() {
+#if defined(__AVR__)
+  return &__heap_start - (uint8_t*)RAMSTART;
+#else
+  return 0;
+#endif
+}
+
+size_t getHeapBytes() {
+#if defined(__AVR__)
+  return heapEnd() - &__heap_start;
+#else
+  return 0;
+#endif
+}
+
+size_t getFreeRamBytes() {
+#if defined(__AVR__)
+  return stackPointer() - heapEnd();
+#else
+  return 0;
+#endif
+}
+
+size_t getMinFreeRamBytes() {
+#if defined(__AVR__)
+  // Heap growth overwrites the paint from below, so count from the heap's end
+  const uint8_t* p = heapEnd();
+  const uint8_t* top = stackPointer();
+  while (p <= top && *p == MEMSTAT_CANARY) p++;
+  return p - heapEnd();
+#else
+  return 0;
+#endif
+}
+
+void reportMemory() {
+  if (!canWriteDebugLine(REPORT_LINE_MAX)) return;
+  reportRequested = false;
+
+  size_t staticBytes = getStaticRamBytes();
+  size_t heapBytes = getHeapBytes();
+  size_t minFree = getMinFreeRamBytes();
+#if defined(__AVR__)
+  size_t stackMax = (uint8_t*)RAMEND - heapEnd() + 1 - minFree;
+#else
+  size_t stackMax = 0;
+#endif
+
+  Serial.print("MEM:");
+  Serial.print(staticBytes);
+  Serial.print(",");
+  Serial.print(heapBytes);
+  Serial.print(",");
+  Serial.print(stackMax);
+  Serial.print(",");
+  Serial.print(getFreeRamBytes());
+  Serial.print(",");
+  Serial.println(minFree);
+}
@@ -0,0 +1,32 @@
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <Arduino.h>
+
+// SRAM usage at run time.
+// Before main() runs, the free RAM between the end of .bss and the top of
+// the stack is painted with MEMSTAT_CANARY. The deepest the stack has ever
+// reached is where the unbroken run of canary bytes above the heap ends, so
+// the high-water mark covers interrupt handlers too and costs nothing until
+// it is asked for.
+//
+// Queried over the ESP32 link: MEMORY_REPORT_REQUEST prints
+//   MEM:<static>,<heap>,<stack max>,<free now>,<free min>
+// in bytes: .data + .bss, heap in use, deepest stack so far, and the gap
+// between heap and stack now and at the stack's deepest point. The host
+// build has no SRAM model and reports zeros.
+
+// Memory statistics configuration
+extern const char MEMORY_REPORT_REQUEST;
+extern const uint8_t MEMSTAT_CANARY;
+
+// Memory statistics functions
+void requestMemoryReport();
+bool isMemoryReportDue();          // Scheduler ready check
+void reportMemory();
+size_t getStaticRamBytes();        // .data + .bss
+size_t getHeapBytes();
+size_t getFreeRamBytes();          // Between the heap and the stack pointer now
+size_t getMinFreeRamBytes();       // Canary bytes never overwritten
+
+#endif
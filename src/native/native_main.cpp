@@ -0,0 +1,769 @@
+// Host entry point for the `native` environment.
+//
+// Runs the firmware's setup()/loop() against the simulated board from the
+// ArduinoNative library and reports how fast the control loop executes on
+// the host. A scripted drive scenario exercises every module: NMEA traffic
+// from the GPS, reverse gear and touch buttons, a dusk light ramp on the
+// photosensor and joystick gestures. Time is virtual, so every run with
+// the same options sees identical inputs.
+//
+//   .pio/build/native/program [--seconds N] [--step-us N] [--echo] [--gps-no-ubx]
+//                             [--gps-ttff-ms N] [--eeprom FILE] [--frames] [--record FILE]
+//   .pio/build/native/program --bench-nmea [--seconds N]
+//   .pio/build/native/program --replay FILE [--seconds N] [--step-us N] [--frames]
+//
+// --gps-no-ubx makes the simulated receiver ignore UBX configuration, to
+// exercise the firmware's fallback to the receiver defaults. --gps-ttff-ms
+// delays the receiver's first fix. --eeprom keeps EEPROM in a file between
+// runs, so a second run starts with the position saved by the first.
+// --frames switches telemetry to binary frames and checks every one.
+// --bench-nmea skips the firmware and instead times the in-tree NMEA parser
+// against TinyGPSPlus on N seconds of recorded-style receiver output.
+// --record FILE writes the scenario's inputs after setup() as a trace, and
+// --replay FILE feeds a trace (recorded on the car or written by hand)
+// through the firmware instead of the scenario, skipping idle time, and
+// prints the output and serial timeline to stdout for diffing.
+
+#include <Arduino.h>
+#include <sim.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <TinyGPS++.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HOST_HAS_TSC 1
+#endif
+
+#include "reverse.h"
+#include "horn.h"
+#include "headlights.h"
+#include "nmea.h"
+#include "telemetry.h"
+#include "adc.h"
+#include "outputs.h"
+#include "relay_config.h"
+#include "scheduler.h"
+#include "timers.h"
+#include "trace.h"
+#include "trace_file.h"
+
+struct BenchOptions {
+  unsigned long seconds = 600;   // virtual seconds to simulate
+  unsigned long stepMicros = 20; // virtual time added per loop(): models one scheduler pass on the AVR
+  bool echo = false;             // copy firmware serial output to stdout
+  bool benchNmea = false;        // run the NMEA parser benchmark instead
+  bool gpsAnswersUbx = true;     // false: receiver ignores UBX configuration
+  unsigned long gpsTtffMs = 0;   // receiver time to first fix
+  const char* eepromFile = nullptr; // EEPROM image loaded before and saved after the run
+  bool telemetryFrames = false;  // binary telemetry instead of KEY:VALUE text
+  bool secondsSet = false;       // --seconds given (a replay otherwise runs to the end of the trace)
+  const char* recordFile = nullptr; // trace of the scenario inputs
+  const char* replayFile = nullptr; // trace to replay instead of the scenario
+};
+
+// Scenario inputs go here as a trace once setup() is done (--record)
+static FILE* traceRecord = nullptr;
+
+struct SerialCapture {
+  bool echo;
+  unsigned long lines;
+  std::string chunk;          // Bytes since the last 0x00 (binary telemetry)
+  unsigned long frames;       // Telemetry frames that decoded with a good CRC
+  unsigned long keyframes;    // Of which keyframes
+  unsigned long frameBytes;   // Wire bytes of those frames, delimiters included
+  unsigned long textChunks;   // Other chunks: free text between frames
+};
+
+// Decodes one COBS chunk and checks the telemetry CRC-16/CCITT-FALSE.
+// Returns the frame type (0x01 delta, 0x02 keyframe), or 0 if it is not a frame.
+static uint8_t telemetryFrameType(const std::string& chunk) {
+  std::string frame;
+  size_t i = 0;
+  while (i < chunk.size()) {
+    uint8_t code = (uint8_t)chunk[i++];
+    if (code == 0 || i + code - 1 > chunk.size()) return 0;
+    frame.append(chunk, i, code - 1);
+    i += code - 1;
+    if (code != 0xFF && i < chunk.size()) frame += '\0';
+  }
+  if (frame.size() < 5 || (frame[0] != 0x01 && frame[0] != 0x02)) return 0;
+  uint16_t crc = 0xFFFF;
+  for (size_t j = 0; j + 2 < frame.size(); j++) {
+    crc ^= (uint16_t)(uint8_t)frame[j] << 8;
+    for (int bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  bool good = (uint8_t)frame[frame.size() - 2] == (crc & 0xFF) && (uint8_t)frame[frame.size() - 1] == (crc >> 8);
+  return good ? (uint8_t)frame[0] : 0;
+}
+
+static void captureSerial(uint8_t c, void* ctx) {
+  SerialCapture* capture = static_cast<SerialCapture*>(ctx);
+  if (c == '\n') capture->lines++;
+  if (capture->echo) fputc(c, stdout);
+
+  if (c != 0) {
+    capture->chunk += (char)c;
+  } else if (!capture->chunk.empty()) {
+    uint8_t type = telemetryFrameType(capture->chunk);
+    if (type != 0) {
+      capture->frames++;
+      if (type == 0x02) capture->keyframes++;
+      capture->frameBytes += capture->chunk.size() + 2;
+    } else {
+      capture->textChunks++;
+    }
+    capture->chunk.clear();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Input-to-output latency probes
+// ---------------------------------------------------------------------------
+
+// Measures virtual time from an input reaching a level (the last transition,
+// so contact bounce is excluded) to the firmware driving an output.
+struct LatencyProbe {
+  const char* name;
+  uint8_t inputPin;
+  uint8_t inputLevel;
+  uint8_t outputPin;
+  uint8_t outputLevel;
+  bool armed;
+  uint64_t armedAt;
+  unsigned long samples;
+  uint64_t totalMicros;
+  uint64_t maxMicros;
+};
+
+static LatencyProbe probes[] = {
+  {"reverse -> camera on", 0, LOW, 0, RELAY_ON, false, 0, 0, 0, 0},
+  {"horn touch -> horn on", 0, HIGH, 0, RELAY_ON, false, 0, 0, 0, 0},
+};
+
+static void setupProbes() {
+  probes[0].inputPin = REVERSE_GEAR_PIN;
+  probes[0].outputPin = CAMERA_MOSFET_PIN;
+  probes[1].inputPin = HORN_BUTTON_PIN;
+  probes[1].outputPin = HORN_MOSFET_PIN;
+}
+
+static void driveInput(uint8_t pin, uint8_t level) {
+  if (simGetPin(pin) == level) return;
+  if (traceRecord) writeTracePin(traceRecord, millis(), pin, level);
+  for (LatencyProbe& probe : probes) {
+    if (probe.inputPin != pin) continue;
+    probe.armed = (level == probe.inputLevel);
+    probe.armedAt = simMicros();
+  }
+  simSetPin(pin, level);
+}
+
+static void driveAnalog(uint8_t pin, int value) {
+  if (simGetAnalog(pin) == value) return;
+  if (traceRecord) writeTraceAnalog(traceRecord, millis(), pin - A0, value);
+  simSetAnalog(pin, value);
+}
+
+static void onPinWrite(uint8_t pin, uint8_t level, void* ctx) {
+  (void)ctx;
+  for (LatencyProbe& probe : probes) {
+    if (!probe.armed || probe.outputPin != pin || probe.outputLevel != level) continue;
+    uint64_t latency = simMicros() - probe.armedAt;
+    probe.armed = false;
+    probe.samples++;
+    probe.totalMicros += latency;
+    if (latency > probe.maxMicros) probe.maxMicros = latency;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Scenario: one minute of driving, repeated
+// ---------------------------------------------------------------------------
+
+static const unsigned long SCENARIO_PERIOD_MS = 60000;
+
+static void appendSentence(std::string& out, const char* body) {
+  uint8_t checksum = 0;
+  for (const char* p = body; *p; p++) checksum ^= (uint8_t)*p;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+  out += '$';
+  out += body;
+  out += tail;
+}
+
+// ---------------------------------------------------------------------------
+// Simulated NEO-6M receiver
+// ---------------------------------------------------------------------------
+
+// Power-on defaults: RMC, VTG, GGA, GSA, 3x GSV and GLL once per second at
+// 9600 baud. UBX CFG-MSG, CFG-RATE and CFG-PRT frames written by the firmware
+// are applied and acknowledged like the real module does; replies only get
+// through when the firmware UART runs at the receiver's baud rate.
+static const uint8_t NMEA_ALL_SENTENCES = 0x3F;  // Bit n = NMEA message ID n (GGA, GLL, GSA, GSV, RMC, VTG)
+
+struct SimReceiver {
+  bool answersUbx;
+  unsigned long baud;
+  uint8_t sentences;
+  unsigned long intervalMs;
+  unsigned long ttffMs;     // Time from power-on to the first valid fix
+  uint8_t frame[64];        // UBX frame being received from the firmware
+  size_t frameLength;
+  unsigned long acks;
+  unsigned long naks;
+  unsigned long aidings;    // AID-INI frames received
+};
+
+static SimReceiver receiver = {true, 9600, NMEA_ALL_SENTENCES, 1000, 0, {0}, 0, 0, 0, 0};
+
+static void receiverTransmit(const uint8_t* data, size_t len) {
+  // A baud mismatch turns everything into framing errors: model as lost
+  if (simGpsPort().baud() != receiver.baud) return;
+  if (traceRecord) writeTraceBytes(traceRecord, millis(), 'G', data, len);
+  simGpsPort().inject(data, len);
+}
+
+static void receiverAck(uint8_t msgClass, uint8_t msgId, bool ack) {
+  uint8_t reply[10] = {0xB5, 0x62, 0x05, (uint8_t)(ack ? 0x01 : 0x00), 2, 0, msgClass, msgId, 0, 0};
+  for (int i = 2; i < 8; i++) {
+    reply[8] += reply[i];
+    reply[9] += reply[8];
+  }
+  (ack ? receiver.acks : receiver.naks)++;
+  receiverTransmit(reply, sizeof(reply));
+}
+
+static void receiverApplyFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length) {
+  if (msgClass == 0x0B && msgId == 0x01 && length == 48) {
+    // AID-INI is not acknowledged. Counted only: how much aiding shortens
+    // TTFF depends on the sky and the receiver's backup state.
+    receiver.aidings++;
+    return;
+  }
+  if (msgClass != 0x06) return;
+  bool ack = false;
+  if (msgId == 0x01 && length == 3 && payload[0] == 0xF0 && payload[1] < 6) {
+    // CFG-MSG: NMEA output rate on this port
+    if (payload[2]) {
+      receiver.sentences |= (1 << payload[1]);
+    } else {
+      receiver.sentences &= ~(1 << payload[1]);
+    }
+    ack = true;
+  } else if (msgId == 0x08 && length == 6) {
+    // CFG-RATE: measurement interval
+    unsigned long interval = payload[0] | (payload[1] << 8);
+    if (interval >= 100) {
+      receiver.intervalMs = interval;
+      ack = true;
+    }
+  } else if (msgId == 0x00 && length == 20 && payload[0] == 1) {
+    // CFG-PRT: the new baud rate applies before the ACK goes out
+    receiver.baud = payload[8] | (payload[9] << 8) | ((unsigned long)payload[10] << 16);
+    ack = true;
+  }
+  receiverAck(msgClass, msgId, ack);
+}
+
+static void receiverInput(uint8_t c, void* ctx) {
+  (void)ctx;
+  if (!receiver.answersUbx) return;
+  uint8_t* frame = receiver.frame;
+  size_t& length = receiver.frameLength;
+
+  // Resynchronise on B5 62, then collect header, payload and checksum
+  if (length == 0 && c != 0xB5) return;
+  if (length == 1 && c != 0x62) {
+    length = (c == 0xB5) ? 1 : 0;
+    return;
+  }
+  frame[length++] = c;
+  if (length < 6) return;
+  uint16_t payloadLength = frame[4] | (frame[5] << 8);
+  if (6 + (size_t)payloadLength + 2 > sizeof(receiver.frame)) {
+    length = 0;
+    return;
+  }
+  if (length < 6 + (size_t)payloadLength + 2) return;
+
+  length = 0;
+  uint8_t ckA = 0;
+  uint8_t ckB = 0;
+  for (size_t i = 2; i < 6 + (size_t)payloadLength; i++) {
+    ckA += frame[i];
+    ckB += ckA;
+  }
+  if (ckA != frame[6 + payloadLength] || ckB != frame[7 + payloadLength]) return;
+  receiverApplyFrame(frame[2], frame[3], frame + 6, payloadLength);
+}
+
+// One navigation epoch of NMEA output, filtered by the enabled sentences
+static std::string gpsEpochBurst(unsigned long epochMs, float speedKmh, uint8_t sentences, bool fix = true) {
+  char body[96];
+  unsigned long second = epochMs / 1000;
+  unsigned long hh = (12 + second / 3600) % 24;
+  unsigned long mm = (second / 60) % 60;
+  unsigned long ss = second % 60;
+  unsigned long cc = (epochMs % 1000) / 10;
+  float knots = speedKmh / 1.852f;
+  std::string burst;
+
+  if (!fix) {
+    // Still searching: RMC void, GGA without a position
+    if (sentences & (1 << 4)) {
+      snprintf(body, sizeof(body), "GPRMC,%02lu%02lu%02lu.%02lu,V,,,,,,,160926,,,N", hh, mm, ss, cc);
+      appendSentence(burst, body);
+    }
+    if (sentences & (1 << 0)) {
+      snprintf(body, sizeof(body), "GPGGA,%02lu%02lu%02lu.%02lu,,,,,0,00,99.99,,,,,,", hh, mm, ss, cc);
+      appendSentence(burst, body);
+    }
+    return burst;
+  }
+  if (sentences & (1 << 4)) {
+    snprintf(body, sizeof(body), "GPRMC,%02lu%02lu%02lu.%02lu,A,4807.03800,N,01131.00000,E,%.3f,77.52,160926,,,A",
+             hh, mm, ss, cc, knots);
+    appendSentence(burst, body);
+  }
+  if (sentences & (1 << 5)) {
+    snprintf(body, sizeof(body), "GPVTG,77.52,T,,M,%.3f,N,%.3f,K,A", knots, speedKmh);
+    appendSentence(burst, body);
+  }
+  if (sentences & (1 << 0)) {
+    snprintf(body, sizeof(body), "GPGGA,%02lu%02lu%02lu.%02lu,4807.03800,N,01131.00000,E,1,08,0.94,545.4,M,46.9,M,,",
+             hh, mm, ss, cc);
+    appendSentence(burst, body);
+  }
+  if (sentences & (1 << 2)) {
+    appendSentence(burst, "GPGSA,A,3,04,05,09,12,24,25,29,31,,,,,1.72,0.94,1.44");
+  }
+  if (sentences & (1 << 3)) {
+    appendSentence(burst, "GPGSV,3,1,11,04,41,298,31,05,53,062,38,09,20,110,27,12,66,200,40");
+    appendSentence(burst, "GPGSV,3,2,11,24,10,045,22,25,33,255,35,29,48,160,41,31,15,320,19");
+    appendSentence(burst, "GPGSV,3,3,11,02,05,012,,17,03,188,,20,01,276,");
+  }
+  if (sentences & (1 << 1)) {
+    snprintf(body, sizeof(body), "GPGLL,4807.03800,N,01131.00000,E,%02lu%02lu%02lu.%02lu,A,A", hh, mm, ss, cc);
+    appendSentence(burst, body);
+  }
+  return burst;
+}
+
+static void feedGpsEpoch(unsigned long epochMs, float speedKmh) {
+  std::string burst = gpsEpochBurst(epochMs, speedKmh, receiver.sentences, epochMs >= receiver.ttffMs);
+  receiverTransmit(reinterpret_cast<const uint8_t*>(burst.data()), burst.size());
+}
+
+// ---------------------------------------------------------------------------
+// Drive scenario
+// ---------------------------------------------------------------------------
+
+static float scenarioSpeed(unsigned long t) {
+  // Parked for 10 s, accelerate to 60 km/h, cruise, brake to a stop at 50 s
+  if (t < 10000) return 0.0f;
+  if (t < 20000) return (t - 10000) * 0.006f;
+  if (t < 40000) return 60.0f;
+  if (t < 50000) return (50000 - t) * 0.006f;
+  return 0.0f;
+}
+
+static int scenarioLightLevel(unsigned long cycle, unsigned long t) {
+  // Alternate a dusk ramp (bright -> dark) and a dawn ramp between cycles,
+  // with a short underpass at 12 s (in low light on the dusk ramp)
+  if (t >= 12000 && t < 14000) return 900;
+  int level = 100 + (int)(t * 800 / SCENARIO_PERIOD_MS);
+  return (cycle % 2 == 0) ? level : 1000 - level;
+}
+
+static void applyScenario(unsigned long nowMs, unsigned long& lastGpsEpoch) {
+  unsigned long cycle = nowMs / SCENARIO_PERIOD_MS;
+  unsigned long t = nowMs % SCENARIO_PERIOD_MS;
+
+  // Reverse gear: engaged (LOW) between 2 s and 6 s, with contact bounce
+  uint8_t reverse = (t >= 2000 && t < 6000) ? LOW : HIGH;
+  if ((t >= 2000 && t < 2020) || (t >= 6000 && t < 6020)) reverse = (t / 3) % 2;
+  driveInput(REVERSE_GEAR_PIN, reverse);
+
+  // Camera button touched briefly at 8 s, horn held from 15 s to 15.4 s
+  driveInput(CAMERA_BUTTON_PIN, (t >= 8000 && t < 8400) ? HIGH : LOW);
+  driveInput(HORN_BUTTON_PIN, (t >= 15000 && t < 15400) ? HIGH : LOW);
+
+  // Joystick: flash at 25 s, toggle beam at 35 s, centered otherwise
+  int joystick = 512;
+  if (t >= 25000 && t < 25250) joystick = 950;
+  if (t >= 35000 && t < 35250) joystick = 60;
+  driveAnalog(JOYSTICK_Y_PIN, joystick);
+
+  driveAnalog(PHOTOSENSOR_PIN, scenarioLightLevel(cycle, t));
+
+  // ESP32 restarts at 45 s and asks for a keyframe
+  static unsigned long keyframeRequestCycle = (unsigned long)-1;
+  if (t >= 45000 && keyframeRequestCycle != cycle) {
+    keyframeRequestCycle = cycle;
+    uint8_t request = (uint8_t)TELEMETRY_KEYFRAME_REQUEST;
+    if (traceRecord) writeTraceBytes(traceRecord, millis(), 'S', &request, 1);
+    simSerialPort().inject(&request, 1);
+  }
+
+  unsigned long epoch = nowMs / receiver.intervalMs;
+  if (epoch != lastGpsEpoch) {
+    lastGpsEpoch = epoch;
+    feedGpsEpoch(epoch * receiver.intervalMs, scenarioSpeed(t));
+  }
+}
+
+// ---------------------------------------------------------------------------
+// NMEA parser benchmark
+// ---------------------------------------------------------------------------
+
+struct ParserTiming {
+  uint64_t nanos;
+  uint64_t cycles;
+  unsigned long fixes;
+};
+
+static uint64_t hostCycles() {
+#ifdef HOST_HAS_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+template <typename Parser>
+static ParserTiming timeParser(Parser& parser, const std::string& stream) {
+  typedef std::chrono::steady_clock Clock;
+  ParserTiming timing = {0, 0, 0};
+  Clock::time_point start = Clock::now();
+  uint64_t startCycles = hostCycles();
+  for (char c : stream) {
+    if (parser.encode(c)) timing.fixes++;
+  }
+  timing.cycles = hostCycles() - startCycles;
+  timing.nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  return timing;
+}
+
+static void reportParser(const char* name, const ParserTiming& timing, size_t bytes) {
+  fprintf(stderr, "%-12s %8.1f MB/s  %6.2f ns/byte  %6.1f cycles/byte  %lu sentences\n", name,
+          bytes / (timing.nanos / 1e9) / 1e6, (double)timing.nanos / bytes,
+          (double)timing.cycles / bytes, timing.fixes);
+}
+
+static int runNmeaBenchmark(unsigned long seconds) {
+  std::string stream;
+  for (unsigned long second = 0; second < seconds; second++) {
+    stream += gpsEpochBurst(second * 1000, scenarioSpeed((second * 1000) % SCENARIO_PERIOD_MS), NMEA_ALL_SENTENCES);
+  }
+
+  TinyGPSPlus tinyGps;
+  NmeaParser nmea;
+  ParserTiming tinyTiming = timeParser(tinyGps, stream);
+  ParserTiming nmeaTiming = timeParser(nmea, stream);
+
+  // Both parsers must end on the same fix, to the parser's resolution
+  int32_t tinyLatitude = (int32_t)lround(tinyGps.location.lat() * 1e6);
+  int32_t tinyLongitude = (int32_t)lround(tinyGps.location.lng() * 1e6);
+  uint32_t tinySpeed = (uint32_t)lround(tinyGps.speed.kmph() * 100);
+  bool agree = nmea.isLocationValid() && nmea.isSpeedValid() &&
+               labs(nmea.latitudeE6() - tinyLatitude) <= 1 &&
+               labs(nmea.longitudeE6() - tinyLongitude) <= 1 &&
+               labs((long)nmea.speedCentiKmh() - (long)tinySpeed) <= 1;
+
+  fprintf(stderr, "nmea stream  %zu bytes (%lu s of receiver output)\n", stream.size(), seconds);
+  reportParser("TinyGPSPlus", tinyTiming, stream.size());
+  reportParser("NmeaParser", nmeaTiming, stream.size());
+#ifndef HOST_HAS_TSC
+  fprintf(stderr, "(cycle counter not available on this host)\n");
+#endif
+  fprintf(stderr, "final fix    %s (checksum failures: %lu)\n", agree ? "match" : "MISMATCH",
+          nmea.checksumFailures());
+  return agree ? 0 : 1;
+}
+
+// EEPROM image on disk, so consecutive runs behave like consecutive trips
+static void loadEeprom(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return;  // First run: EEPROM stays erased
+  size_t read = fread(simEepromData(), 1, simEepromSize(), file);
+  (void)read;
+  fclose(file);
+}
+
+static void saveEeprom(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return;
+  }
+  fwrite(simEepromData(), 1, simEepromSize(), file);
+  fclose(file);
+}
+
+// ---------------------------------------------------------------------------
+// Trace record and replay
+// ---------------------------------------------------------------------------
+
+static const uint8_t TRACE_INPUT_PINS[] = {REVERSE_GEAR_PIN, CAMERA_BUTTON_PIN, HORN_BUTTON_PIN};
+static const uint8_t TRACE_ANALOG_PINS[] = {PHOTOSENSOR_PIN, JOYSTICK_Y_PIN};
+
+static void startTraceRecord(const char* path) {
+  traceRecord = fopen(path, "w");
+  if (!traceRecord) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return;
+  }
+  // Levels at the end of setup(), like the firmware's first trace lines
+  fprintf(traceRecord, "# Scenario inputs from the native build, ms since boot\n");
+  for (uint8_t pin : TRACE_INPUT_PINS) writeTracePin(traceRecord, millis(), pin, simGetPin(pin));
+  for (uint8_t pin : TRACE_ANALOG_PINS) writeTraceAnalog(traceRecord, millis(), pin - A0, simGetAnalog(pin));
+}
+
+// Relay outputs named in the replay timeline
+struct TimelineOutput {
+  const char* name;
+  uint8_t pin;
+  uint8_t level;   // Last level written, 0xFF = not yet
+};
+
+static TimelineOutput timelineOutputs[] = {
+  {"DRL", 0, 0xFF}, {"TAIL_LIGHT", 0, 0xFF}, {"LOW_BEAM", 0, 0xFF},
+  {"HIGH_BEAM", 0, 0xFF}, {"HORN", 0, 0xFF}, {"CAMERA", 0, 0xFF},
+};
+
+static void onTimelinePinWrite(uint8_t pin, uint8_t level, void* ctx) {
+  onPinWrite(pin, level, ctx);
+  for (TimelineOutput& output : timelineOutputs) {
+    if (output.pin != pin || output.level == level) continue;
+    output.level = level;
+    printf("%10lu %s %s\n", millis(), output.name, level == RELAY_ON ? "ON" : "OFF");
+  }
+}
+
+static void timelineSerial(uint8_t c, void* ctx) {
+  std::string* line = static_cast<std::string*>(ctx);
+  if (c == '\r') return;
+  if (c != '\n') {
+    *line += (char)c;
+    return;
+  }
+  printf("%10lu > %s\n", millis(), line->c_str());
+  line->clear();
+}
+
+static void applyTraceEvent(const TraceEvent& event, unsigned long& gpsLost) {
+  switch (event.kind) {
+    case 'P':
+      driveInput(event.index, event.value ? HIGH : LOW);
+      break;
+    case 'A':
+      simSetAnalog(event.index, (int)event.value);
+      break;
+    case 'G':
+      simGpsPort().inject(reinterpret_cast<const uint8_t*>(event.bytes.data()), event.bytes.size());
+      break;
+    case 'S':
+      simSerialPort().inject(reinterpret_cast<const uint8_t*>(event.bytes.data()), event.bytes.size());
+      break;
+    case 'X':
+      gpsLost = (unsigned long)event.value;
+      break;
+  }
+}
+
+// Runs the firmware on a trace. Virtual time only moves as far as the next
+// scheduler release, timer deadline or trace event, so hours of driving,
+// mostly waiting on 60 s debounces, take a fraction of a second.
+static int runReplay(const BenchOptions& options) {
+  typedef std::chrono::steady_clock Clock;
+
+  std::vector<TraceEvent> events;
+  unsigned long skipped = 0;
+  if (!readTrace(options.replayFile, events, skipped)) {
+    fprintf(stderr, "cannot read %s\n", options.replayFile);
+    return 2;
+  }
+
+  simReset();
+  std::string line;
+  simSerialPort().setTxSink(timelineSerial, &line);
+  setupProbes();
+  timelineOutputs[0].pin = DRL_MOSFET_PIN;
+  timelineOutputs[1].pin = TAIL_LIGHT_MOSFET_PIN;
+  timelineOutputs[2].pin = LOW_BEAM_MOSFET_PIN;
+  timelineOutputs[3].pin = HIGH_BEAM_MOSFET_PIN;
+  timelineOutputs[4].pin = HORN_MOSFET_PIN;
+  timelineOutputs[5].pin = CAMERA_MOSFET_PIN;
+  simOnPinWrite(onTimelinePinWrite, nullptr);
+  if (options.eepromFile) loadEeprom(options.eepromFile);
+  setTelemetryFormat(options.telemetryFrames ? TELEMETRY_FRAMES : TELEMETRY_TEXT);
+
+  // The first level of every input is there from power-on; the trace starts
+  // after the firmware's setup()
+  std::vector<bool> seen(256, false);
+  for (const TraceEvent& event : events) {
+    if (event.kind != 'P' && event.kind != 'A') continue;
+    uint8_t key = (uint8_t)(event.kind == 'P' ? event.index : 128 + event.index);
+    if (seen[key]) continue;
+    seen[key] = true;
+    if (event.kind == 'P') simSetPin(event.index, event.value ? HIGH : LOW);
+    else simSetAnalog(event.index, (int)event.value);
+  }
+
+  Clock::time_point start = Clock::now();
+  setup();
+
+  unsigned long endMs = events.empty() ? 0 : events.back().ms + 1000;
+  if (options.secondsSet) endMs = options.seconds * 1000;
+  size_t next = 0;
+  unsigned long passes = 0;
+  unsigned long gpsLost = 0;
+  while (millis() < endMs) {
+    while (next < events.size() && events[next].ms <= millis()) {
+      applyTraceEvent(events[next++], gpsLost);
+    }
+
+    loop();
+    passes++;
+
+    // Busy: one scheduler pass worth of time. Idle: straight to whatever
+    // comes first. Bytes still on their way in from a UART are delivered by
+    // the skip at their line rate and wait in the receive buffer.
+    unsigned long wait = millisUntilNextTask();
+    unsigned long timer = millisUntilNextTimer();
+    if (timer < wait) wait = timer;
+    if (wait == 0) {
+      simAdvanceMicros(options.stepMicros);
+      continue;
+    }
+    unsigned long target = millis() + wait;
+    if (next < events.size() && events[next].ms < target) target = events[next].ms;
+    if (target > endMs) target = endMs;
+    uint64_t targetMicros = (uint64_t)target * 1000;
+    simAdvanceMicros(targetMicros > simMicros() ? targetMicros - simMicros() : options.stepMicros);
+  }
+  double hostSeconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count() / 1e9;
+  if (!line.empty()) printf("%10lu > %s\n", millis(), line.c_str());
+
+  double virtualSeconds = simMicros() / 1e6;
+  fprintf(stderr, "trace               %zu events, %lu other lines skipped\n", events.size(), skipped);
+  if (gpsLost) fprintf(stderr, "trace gps bytes     %lu lost while recording\n", gpsLost);
+  fprintf(stderr, "virtual time        %.1f s in %lu loop passes\n", virtualSeconds, passes);
+  fprintf(stderr, "host time           %.3f s (%.0fx real time)\n", hostSeconds, virtualSeconds / hostSeconds);
+  for (const LatencyProbe& probe : probes) {
+    fprintf(stderr, "%-22s %lu events, mean %.0f us, max %llu us\n", probe.name, probe.samples,
+            probe.samples ? (double)probe.totalMicros / probe.samples : 0.0, (unsigned long long)probe.maxMicros);
+  }
+  if (options.eepromFile) saveEeprom(options.eepromFile);
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      options.seconds = strtoul(argv[++i], nullptr, 10);
+      options.secondsSet = true;
+    } else if (strcmp(argv[i], "--step-us") == 0 && i + 1 < argc) {
+      options.stepMicros = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--echo") == 0) {
+      options.echo = true;
+    } else if (strcmp(argv[i], "--bench-nmea") == 0) {
+      options.benchNmea = true;
+    } else if (strcmp(argv[i], "--gps-no-ubx") == 0) {
+      options.gpsAnswersUbx = false;
+    } else if (strcmp(argv[i], "--gps-ttff-ms") == 0 && i + 1 < argc) {
+      options.gpsTtffMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc) {
+      options.eepromFile = argv[++i];
+    } else if (strcmp(argv[i], "--frames") == 0) {
+      options.telemetryFrames = true;
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      options.recordFile = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      options.replayFile = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--step-us N] [--echo] [--gps-no-ubx] [--gps-ttff-ms N]\n"
+                      "       [--eeprom FILE] [--frames] [--record FILE] [--replay FILE] [--bench-nmea]\n", argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  if (!parseOptions(argc, argv, options)) return 2;
+  if (options.benchNmea) return runNmeaBenchmark(options.seconds);
+  if (options.replayFile) return runReplay(options);
+
+  typedef std::chrono::steady_clock Clock;
+
+  simReset();
+  SerialCapture capture = {options.echo, 0, std::string(), 0, 0, 0, 0};
+  simSerialPort().setTxSink(captureSerial, &capture);
+  setupProbes();
+  simOnPinWrite(onPinWrite, nullptr);
+
+  unsigned long lastGpsEpoch = (unsigned long)-1;
+  receiver.answersUbx = options.gpsAnswersUbx;
+  receiver.ttffMs = options.gpsTtffMs;
+  if (options.eepromFile) loadEeprom(options.eepromFile);
+  setTelemetryFormat(options.telemetryFrames ? TELEMETRY_FRAMES : TELEMETRY_TEXT);
+  simGpsPort().setTxSink(receiverInput, nullptr);
+  applyScenario(0, lastGpsEpoch);
+  setup();
+  if (options.recordFile) startTraceRecord(options.recordFile);
+
+  const uint64_t endMicros = simMicros() + (uint64_t)options.seconds * 1000000ULL;
+  unsigned long loops = 0;
+  uint64_t loopNanosTotal = 0;
+  uint64_t loopNanosMax = 0;
+
+  while (simMicros() < endMicros) {
+    applyScenario(millis(), lastGpsEpoch);
+
+    Clock::time_point start = Clock::now();
+    loop();
+    uint64_t nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    loopNanosTotal += nanos;
+    if (nanos > loopNanosMax) loopNanosMax = nanos;
+    loops++;
+    simAdvanceMicros(options.stepMicros);
+  }
+
+  SimUart& esp32 = simSerialPort();
+  SimUart& gpsPort = simGpsPort();
+  double virtualSeconds = simMicros() / 1e6;
+
+  fprintf(stderr, "virtual time        %.1f s\n", virtualSeconds);
+  fprintf(stderr, "loop iterations     %lu (%.1f per virtual second)\n", loops, loops / virtualSeconds);
+  fprintf(stderr, "host time in loop() %.3f ms (mean %.0f ns, max %llu ns)\n",
+          loopNanosTotal / 1e6, loops ? (double)loopNanosTotal / loops : 0.0, (unsigned long long)loopNanosMax);
+  fprintf(stderr, "speedup             %.0fx real time\n", virtualSeconds / (loopNanosTotal / 1e9));
+  fprintf(stderr, "serial out          %lu bytes, %lu lines, %.1f ms blocked on full TX buffer\n",
+          esp32.txBytes, capture.lines, esp32.txBlockedMicros / 1000.0);
+  if (options.telemetryFrames) {
+    fprintf(stderr, "telemetry frames    %lu good (%lu keyframes, %lu bytes), %lu text chunks between them\n",
+            capture.frames, capture.keyframes, capture.frameBytes, capture.textChunks);
+  }
+  fprintf(stderr, "gps in              %lu bytes delivered, %lu dropped on RX overflow\n",
+          gpsPort.rxDelivered, gpsPort.rxOverflows);
+  fprintf(stderr, "gps receiver        %lu ms epochs, sentence mask 0x%02X, %lu baud, %lu UBX acks, %lu naks, %lu AID-INI\n",
+          receiver.intervalMs, receiver.sentences, receiver.baud, receiver.acks, receiver.naks, receiver.aidings);
+  fprintf(stderr, "eeprom              %lu byte writes\n", simEepromWrites());
+  fprintf(stderr, "analogRead calls    %lu (blocking), %lu scanner conversions\n", simAnalogReads(),
+          getAdcConversions());
+  for (const LatencyProbe& probe : probes) {
+    fprintf(stderr, "%-22s %lu events, mean %.0f us, max %llu us\n", probe.name, probe.samples,
+            probe.samples ? (double)probe.totalMicros / probe.samples : 0.0, (unsigned long long)probe.maxMicros);
+  }
+  if (options.eepromFile) saveEeprom(options.eepromFile);
+  if (traceRecord) fclose(traceRecord);
+  return 0;
+}
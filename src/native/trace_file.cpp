@@ -0,0 +1,90 @@
+#include "trace_file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "trace.h"
+
+static const size_t TRACE_CHUNK_BYTES = 16;
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static bool parseTraceLine(const char* line, TraceEvent& event) {
+  size_t prefixLength = strlen(TRACE_LINE_PREFIX);
+  if (strncmp(line, TRACE_LINE_PREFIX, prefixLength) == 0) line += prefixLength;
+  if (*line < '0' || *line > '9') return false;
+
+  char* end;
+  event.ms = strtoul(line, &end, 10);
+  if (end[0] != ',' || end[1] == '\0' || end[2] != ',') return false;
+  event.kind = end[1];
+  const char* args = end + 3;
+  event.index = 0;
+  event.value = 0;
+  event.bytes.clear();
+
+  switch (event.kind) {
+    case 'P':
+    case 'A': {
+      event.index = (uint8_t)strtoul(args, &end, 10);
+      if (*end != ',') return false;
+      event.value = strtol(end + 1, &end, 10);
+      return true;
+    }
+    case 'G':
+    case 'S': {
+      for (const char* p = args; hexDigit(p[0]) >= 0 && hexDigit(p[1]) >= 0; p += 2) {
+        event.bytes += (char)(hexDigit(p[0]) << 4 | hexDigit(p[1]));
+      }
+      return !event.bytes.empty();
+    }
+    case 'X':
+      event.value = strtol(args, &end, 10);
+      return end != args;
+    default:
+      return false;
+  }
+}
+
+bool readTrace(const char* path, std::vector<TraceEvent>& events, unsigned long& skippedLines) {
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+
+  char line[256];
+  TraceEvent event;
+  skippedLines = 0;
+  while (fgets(line, sizeof(line), file)) {
+    if (parseTraceLine(line, event)) {
+      events.push_back(event);
+    } else if (line[0] != '#' && line[0] != '\n' && line[0] != '\r') {
+      skippedLines++;
+    }
+  }
+  fclose(file);
+
+  std::stable_sort(events.begin(), events.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) { return a.ms < b.ms; });
+  return true;
+}
+
+void writeTracePin(FILE* file, unsigned long ms, uint8_t pin, uint8_t level) {
+  fprintf(file, "%lu,P,%u,%u\n", ms, pin, level);
+}
+
+void writeTraceAnalog(FILE* file, unsigned long ms, uint8_t channel, int value) {
+  fprintf(file, "%lu,A,%u,%d\n", ms, channel, value);
+}
+
+void writeTraceBytes(FILE* file, unsigned long ms, char kind, const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; i += TRACE_CHUNK_BYTES) {
+    fprintf(file, "%lu,%c,", ms, kind);
+    for (size_t j = i; j < len && j < i + TRACE_CHUNK_BYTES; j++) {
+      fprintf(file, "%02X", data[j]);
+    }
+    fputc('\n', file);
+  }
+}
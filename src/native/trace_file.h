@@ -0,0 +1,38 @@
+#ifndef NATIVE_TRACE_FILE_H
+#define NATIVE_TRACE_FILE_H
+
+// Input traces for the host build: reading them for --replay and writing
+// them for --record. The line format is the one the firmware prints with
+// TRACE_RECORD (see trace.h):
+//   [TRC:]<ms>,P,<pin>,<level>
+//   [TRC:]<ms>,A,<channel>,<value>
+//   [TRC:]<ms>,G,<hex bytes>
+//   [TRC:]<ms>,S,<hex bytes>
+//   [TRC:]<ms>,X,<count>
+// Any other line (firmware output in a serial capture, # comments) is skipped.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+  unsigned long ms;
+  char kind;            // 'P', 'A', 'G', 'S' or 'X'
+  uint8_t index;        // P: pin, A: ADC channel
+  long value;           // P: level, A: reading, X: GPS bytes lost while recording
+  std::string bytes;    // G, S: the raw bytes
+};
+
+// Loads a whole trace, ordered by time (the firmware prints buffered GPS
+// bytes after the pin lines of the same tick). Returns false if the file
+// cannot be read.
+bool readTrace(const char* path, std::vector<TraceEvent>& events, unsigned long& skippedLines);
+
+// Writes synthetic trace lines (no prefix); bytes are split into lines of
+// at most 16 like the firmware does
+void writeTracePin(FILE* file, unsigned long ms, uint8_t pin, uint8_t level);
+void writeTraceAnalog(FILE* file, unsigned long ms, uint8_t channel, int value);
+void writeTraceBytes(FILE* file, unsigned long ms, char kind, const uint8_t* data, size_t len);
+
+#endif
@@ -0,0 +1,235 @@
+#include "nmea.h"
+
+// Fields present in the sentence being parsed
+static const uint8_t PENDING_LATITUDE = 0x01;
+static const uint8_t PENDING_LONGITUDE = 0x02;
+static const uint8_t PENDING_SPEED = 0x04;
+static const uint8_t PENDING_TIME = 0x08;
+static const uint8_t PENDING_DATE = 0x10;
+static const uint8_t PENDING_SATELLITES = 0x20;
+static const uint8_t PENDING_POSITION = PENDING_LATITUDE | PENDING_LONGITUDE;
+
+// Fraction digits kept per numeric field (enough for ddmm.mmmmm coordinates)
+static const uint8_t MAX_FRACTION_DIGITS = 6;
+
+// Tables are in flash (PROGMEM), like the other lookup tables
+static const uint32_t POWERS_OF_TEN[] PROGMEM = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+// Meaning of each comma-separated field, per sentence type
+enum NmeaField : uint8_t {
+  FIELD_NONE, FIELD_TIME, FIELD_STATUS, FIELD_LATITUDE, FIELD_NORTH_SOUTH, FIELD_LONGITUDE,
+  FIELD_EAST_WEST, FIELD_SPEED_KNOTS, FIELD_DATE, FIELD_FIX_QUALITY, FIELD_SATELLITES
+};
+static const NmeaField RMC_FIELDS[] PROGMEM = {
+  FIELD_NONE, FIELD_TIME, FIELD_STATUS, FIELD_LATITUDE, FIELD_NORTH_SOUTH, FIELD_LONGITUDE,
+  FIELD_EAST_WEST, FIELD_SPEED_KNOTS, FIELD_NONE, FIELD_DATE
+};
+static const NmeaField GGA_FIELDS[] PROGMEM = {
+  FIELD_NONE, FIELD_TIME, FIELD_LATITUDE, FIELD_NORTH_SOUTH, FIELD_LONGITUDE, FIELD_EAST_WEST,
+  FIELD_FIX_QUALITY, FIELD_SATELLITES
+};
+
+NmeaParser::NmeaParser()
+  : inSentence(false), inChecksum(false), sentence(SENTENCE_OTHER), field(0), checksum(0),
+    receivedChecksum(0), checksumDigits(0), typeLength(0),
+    pendingActive(false), pendingFields(0), pendingLatitude(0), pendingLongitude(0),
+    pendingSpeed(0), pendingTime(0), pendingDate(0), pendingSatellites(0),
+    locationValid(false), speedValid(false), latitude(0), longitude(0), speed(0),
+    time(0), dateDdmmyy(0), satelliteCount(0), passed(0), failed(0) {
+  startField();
+}
+
+bool NmeaParser::encode(char c) {
+  if (c == '$') {
+    inSentence = true;
+    inChecksum = false;
+    sentence = SENTENCE_OTHER;
+    field = 0;
+    checksum = 0;
+    typeLength = 0;
+    pendingActive = false;
+    pendingFields = 0;
+    startField();
+    return false;
+  }
+  if (!inSentence) return false;
+
+  if (inChecksum) {
+    uint8_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else if (c == '\r' || c == '\n') {
+      inSentence = false;
+      return endSentence();
+    } else {
+      inSentence = false; // Garbage after '*'
+      return false;
+    }
+    receivedChecksum = (receivedChecksum << 4) | digit;
+    checksumDigits++;
+    return false;
+  }
+
+  if (c == '*') {
+    endField();
+    inChecksum = true;
+    receivedChecksum = 0;
+    checksumDigits = 0;
+    return false;
+  }
+  if (c == '\r' || c == '\n') {
+    inSentence = false; // No checksum: never trusted
+    return false;
+  }
+
+  checksum ^= (uint8_t)c;
+
+  if (c == ',') {
+    endField();
+    if (!inSentence) return false; // Sentence type we do not use
+    field++;
+    startField();
+    return false;
+  }
+
+  if (field == 0) {
+    if (typeLength < sizeof(typeChars)) typeChars[typeLength++] = c;
+    return false;
+  }
+
+  if (fieldEmpty) {
+    fieldFirst = c;
+    fieldEmpty = false;
+  }
+  if (c >= '0' && c <= '9') {
+    if (!fieldDot) {
+      fieldInt = fieldInt * 10 + (c - '0');
+    } else if (fieldFracDigits < MAX_FRACTION_DIGITS) {
+      fieldFrac = fieldFrac * 10 + (c - '0');
+      fieldFracDigits++;
+    }
+  } else if (c == '.') {
+    fieldDot = true;
+  }
+  return false;
+}
+
+void NmeaParser::startField() {
+  fieldInt = 0;
+  fieldFrac = 0;
+  fieldFracDigits = 0;
+  fieldFirst = '\0';
+  fieldEmpty = true;
+  fieldDot = false;
+}
+
+uint32_t NmeaParser::fieldFraction(uint8_t decimals) const {
+  // Fraction digits scaled (truncated) to the requested number of decimals
+  if (fieldFracDigits > decimals) {
+    return fieldFrac / pgm_read_dword(&POWERS_OF_TEN[fieldFracDigits - decimals]);
+  }
+  return fieldFrac * pgm_read_dword(&POWERS_OF_TEN[decimals - fieldFracDigits]);
+}
+
+uint32_t NmeaParser::fieldValue(uint8_t decimals) const {
+  // Integer part and fraction, scaled to the requested number of decimals
+  return fieldInt * pgm_read_dword(&POWERS_OF_TEN[decimals]) + fieldFraction(decimals);
+}
+
+int32_t NmeaParser::coordinateE6() const {
+  // (d)ddmm.mmmmmm -> micro-degrees, rounded
+  uint32_t degrees = fieldInt / 100;
+  // (the whole field scaled to 1e6 would overflow 32 bits, so split it first)
+  uint32_t minutesE6 = (fieldInt % 100) * 1000000UL + fieldFraction(MAX_FRACTION_DIGITS);
+  return (int32_t)(degrees * 1000000UL + (minutesE6 + 30) / 60);
+}
+
+void NmeaParser::endField() {
+  if (field == 0) {
+    // Talker ID (GP, GN, ...) followed by the sentence type
+    if (typeLength == 5 && typeChars[2] == 'R' && typeChars[3] == 'M' && typeChars[4] == 'C') {
+      sentence = SENTENCE_RMC;
+    } else if (typeLength == 5 && typeChars[2] == 'G' && typeChars[3] == 'G' && typeChars[4] == 'A') {
+      sentence = SENTENCE_GGA;
+    } else {
+      inSentence = false; // Skip the rest until the next '$'
+    }
+    return;
+  }
+  if (fieldEmpty) return;
+
+  NmeaField meaning = FIELD_NONE;
+  if (sentence == SENTENCE_RMC && field < sizeof(RMC_FIELDS)) {
+    meaning = (NmeaField)pgm_read_byte(&RMC_FIELDS[field]);
+  } else if (sentence == SENTENCE_GGA && field < sizeof(GGA_FIELDS)) {
+    meaning = (NmeaField)pgm_read_byte(&GGA_FIELDS[field]);
+  }
+
+  switch (meaning) {
+    case FIELD_TIME:
+      pendingTime = fieldValue(2);
+      pendingFields |= PENDING_TIME;
+      break;
+    case FIELD_STATUS:
+      pendingActive = (fieldFirst == 'A');
+      break;
+    case FIELD_LATITUDE:
+      pendingLatitude = coordinateE6();
+      pendingFields |= PENDING_LATITUDE;
+      break;
+    case FIELD_NORTH_SOUTH:
+      if (fieldFirst == 'S') pendingLatitude = -pendingLatitude;
+      break;
+    case FIELD_LONGITUDE:
+      pendingLongitude = coordinateE6();
+      pendingFields |= PENDING_LONGITUDE;
+      break;
+    case FIELD_EAST_WEST:
+      if (fieldFirst == 'W') pendingLongitude = -pendingLongitude;
+      break;
+    case FIELD_SPEED_KNOTS:
+      // knots * 1000 -> km/h * 100 (1 knot = 1.852 km/h)
+      pendingSpeed = (fieldValue(3) * 1852UL + 5000) / 10000;
+      pendingFields |= PENDING_SPEED;
+      break;
+    case FIELD_DATE:
+      pendingDate = fieldInt;
+      pendingFields |= PENDING_DATE;
+      break;
+    case FIELD_FIX_QUALITY:
+      pendingActive = (fieldInt > 0);
+      break;
+    case FIELD_SATELLITES:
+      pendingSatellites = (uint8_t)fieldInt;
+      pendingFields |= PENDING_SATELLITES;
+      break;
+    case FIELD_NONE:
+      break;
+  }
+}
+
+bool NmeaParser::endSentence() {
+  if (checksumDigits != 2 || receivedChecksum != checksum) {
+    failed++;
+    return false;
+  }
+  passed++;
+
+  if (pendingFields & PENDING_TIME) time = pendingTime;
+  if (!pendingActive) return true; // Valid sentence, but no fix yet
+
+  if ((pendingFields & PENDING_POSITION) == PENDING_POSITION) {
+    latitude = pendingLatitude;
+    longitude = pendingLongitude;
+    locationValid = true;
+  }
+  if (pendingFields & PENDING_SPEED) {
+    speed = pendingSpeed;
+    speedValid = true;
+  }
+  if (pendingFields & PENDING_DATE) dateDdmmyy = pendingDate;
+  if (pendingFields & PENDING_SATELLITES) satelliteCount = pendingSatellites;
+  return true;
+}
@@ -0,0 +1,85 @@
+#ifndef NMEA_H
+#define NMEA_H
+
+#include <Arduino.h>
+
+// Incremental NMEA 0183 parser for the two sentences the firmware uses:
+// RMC (position, speed, date) and GGA (position, fix quality, satellites).
+// Works on one byte at a time with no floating point: coordinates are kept
+// as micro-degrees and speed as centi-km/h. The checksum is accumulated as
+// bytes arrive and a sentence only updates the fix if it matches.
+class NmeaParser {
+public:
+  NmeaParser();
+
+  // Feed one byte; returns true when a valid RMC or GGA sentence was committed
+  bool encode(char c);
+
+  // Latest committed values
+  bool isLocationValid() const { return locationValid; }
+  bool isSpeedValid() const { return speedValid; }
+  int32_t latitudeE6() const { return latitude; }    // Micro-degrees, north positive
+  int32_t longitudeE6() const { return longitude; }  // Micro-degrees, east positive
+  uint32_t speedCentiKmh() const { return speed; }   // km/h * 100
+  uint32_t timeCentis() const { return time; }       // UTC hhmmsscc
+  uint32_t date() const { return dateDdmmyy; }       // UTC ddmmyy
+  uint8_t satellites() const { return satelliteCount; }
+
+  // Statistics
+  unsigned long sentencesPassed() const { return passed; }
+  unsigned long checksumFailures() const { return failed; }
+
+private:
+  enum Sentence : uint8_t { SENTENCE_OTHER, SENTENCE_RMC, SENTENCE_GGA };
+
+  void startField();
+  void endField();
+  bool endSentence();
+  int32_t coordinateE6() const;
+  uint32_t fieldFraction(uint8_t decimals) const;
+  uint32_t fieldValue(uint8_t decimals) const;
+
+  // Sentence being parsed
+  bool inSentence;
+  bool inChecksum;
+  Sentence sentence;
+  uint8_t field;
+  uint8_t checksum;
+  uint8_t receivedChecksum;
+  uint8_t checksumDigits;
+  char typeChars[5];
+  uint8_t typeLength;
+
+  // Current field
+  uint32_t fieldInt;
+  uint32_t fieldFrac;
+  uint8_t fieldFracDigits;
+  char fieldFirst;
+  bool fieldEmpty;
+  bool fieldDot;
+
+  // Values pending until the checksum is confirmed
+  bool pendingActive;       // RMC status 'A' / GGA fix quality > 0
+  uint8_t pendingFields;    // PENDING_* bits for fields that were present
+  int32_t pendingLatitude;
+  int32_t pendingLongitude;
+  uint32_t pendingSpeed;
+  uint32_t pendingTime;
+  uint32_t pendingDate;
+  uint8_t pendingSatellites;
+
+  // Committed fix
+  bool locationValid;
+  bool speedValid;
+  int32_t latitude;
+  int32_t longitude;
+  uint32_t speed;
+  uint32_t time;
+  uint32_t dateDdmmyy;
+  uint8_t satelliteCount;
+
+  unsigned long passed;
+  unsigned long failed;
+};
+
+#endif
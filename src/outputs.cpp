@@ -0,0 +1,114 @@
+#include "outputs.h"
+#include "fastpin.h"
+#include "headlights.h"
+#include "horn.h"
+#include "reverse.h"
+#include "telemetry.h"
+
+struct OutputPin {
+  uint8_t output;
+  uint8_t pin;
+  uint8_t telemetryBit; // TELEMETRY_STATE_* bit, 0 if not reported
+};
+
+static const OutputPin OUTPUT_PINS[] = {
+  {OUTPUT_DRL,        DRL_MOSFET_PIN,        TELEMETRY_STATE_DRL},
+  {OUTPUT_TAIL_LIGHT, TAIL_LIGHT_MOSFET_PIN, TELEMETRY_STATE_TAIL_LIGHT},
+  {OUTPUT_LOW_BEAM,   LOW_BEAM_MOSFET_PIN,   TELEMETRY_STATE_LOW_BEAM},
+  {OUTPUT_HIGH_BEAM,  HIGH_BEAM_MOSFET_PIN,  TELEMETRY_STATE_HIGH_BEAM},
+  {OUTPUT_HORN,       HORN_MOSFET_PIN,       0},
+  {OUTPUT_CAMERA,     CAMERA_MOSFET_PIN,     0},
+};
+static const uint8_t OUTPUT_PIN_COUNT = sizeof(OUTPUT_PINS) / sizeof(OUTPUT_PINS[0]);
+
+static uint8_t shadowOutputs = 0;
+static uint8_t committedOutputs = 0;
+static uint8_t claimedOutputs = 0;
+
+void setupOutputs() {
+  // Level latched before each pin becomes an output: no relay pulse at boot
+  RelayPin<DRL_MOSFET_PIN>::setup();
+  RelayPin<TAIL_LIGHT_MOSFET_PIN>::setup();
+  RelayPin<LOW_BEAM_MOSFET_PIN>::setup();
+  RelayPin<HIGH_BEAM_MOSFET_PIN>::setup();
+  RelayPin<HORN_MOSFET_PIN>::setup();
+  RelayPin<CAMERA_MOSFET_PIN>::setup();
+  shadowOutputs = 0;
+  committedOutputs = 0;
+  claimedOutputs = 0;
+}
+
+void setOutput(uint8_t output, bool on) {
+  shadowOutputs = on ? (shadowOutputs | output) : (shadowOutputs & ~output);
+}
+
+bool isOutputOn(uint8_t output) {
+  return (shadowOutputs & output) != 0;
+}
+
+uint8_t getOutputs() {
+  return shadowOutputs;
+}
+
+uint8_t claimOutputs(uint8_t outputs) {
+  uint8_t claimed = outputs & ~claimedOutputs;
+  claimedOutputs |= outputs;
+  return claimed;
+}
+
+void releaseOutputs(uint8_t outputs) {
+  // The ISR left the pins in an unknown state: mark them as differing from
+  // the shadow so the next commit rewrites (and republishes) them
+  claimedOutputs &= ~outputs;
+  committedOutputs = (committedOutputs & ~outputs) | (~shadowOutputs & outputs);
+}
+
+static void writeOutputPins(uint8_t outputs, uint8_t levels) {
+#if defined(__AVR__)
+  // Pin levels per port (B, C, D), then one masked write per port; the
+  // caller keeps interrupts off so an ISR-owned bit is never clobbered
+  uint8_t masks[3] = {0, 0, 0};
+  uint8_t pinLevels[3] = {0, 0, 0};
+  for (uint8_t i = 0; i < OUTPUT_PIN_COUNT; i++) {
+    const OutputPin& out = OUTPUT_PINS[i];
+    if (!(outputs & out.output)) continue;
+    uint8_t port = fastPinPort(out.pin);
+    uint8_t mask = fastPinMask(out.pin);
+    bool on = (levels & out.output) != 0;
+    masks[port] |= mask;
+    if ((on ? RELAY_ON : RELAY_OFF) == HIGH) pinLevels[port] |= mask;
+  }
+  if (masks[FASTPIN_PORT_B]) PORTB = (PORTB & ~masks[FASTPIN_PORT_B]) | pinLevels[FASTPIN_PORT_B];
+  if (masks[FASTPIN_PORT_C]) PORTC = (PORTC & ~masks[FASTPIN_PORT_C]) | pinLevels[FASTPIN_PORT_C];
+  if (masks[FASTPIN_PORT_D]) PORTD = (PORTD & ~masks[FASTPIN_PORT_D]) | pinLevels[FASTPIN_PORT_D];
+#else
+  for (uint8_t i = 0; i < OUTPUT_PIN_COUNT; i++) {
+    const OutputPin& out = OUTPUT_PINS[i];
+    if (!(outputs & out.output)) continue;
+    digitalWrite(out.pin, (levels & out.output) ? RELAY_ON : RELAY_OFF);
+  }
+#endif
+}
+
+void driveOutputs(uint8_t outputs, uint8_t levels) {
+  writeOutputPins(outputs & claimedOutputs, levels);
+}
+
+void commitOutputs() {
+  uint8_t changed = (shadowOutputs ^ committedOutputs) & ~claimedOutputs;
+  if (changed == 0) return;
+
+  noInterrupts();
+  writeOutputPins(changed, shadowOutputs);
+  interrupts();
+
+  committedOutputs ^= changed;
+
+  // The commit is what the ESP32 sees: publish the outputs that changed
+  for (uint8_t i = 0; i < OUTPUT_PIN_COUNT; i++) {
+    const OutputPin& out = OUTPUT_PINS[i];
+    if ((changed & out.output) && out.telemetryBit) {
+      publishState(out.telemetryBit, (committedOutputs & out.output) != 0);
+    }
+  }
+}
@@ -0,0 +1,34 @@
+#ifndef OUTPUTS_H
+#define OUTPUTS_H
+
+#include <Arduino.h>
+
+// Shadow image of the relay/MOSFET outputs.
+// Modules only change the shadow with setOutput(); commitOutputs() runs after
+// every scheduler tick and applies all changes at once, with a single
+// read-modify-write per port, so related outputs (e.g. low and high beam)
+// always switch together. Changed outputs are published to telemetry from
+// the commit, so modules don't report their own output states.
+//
+// An output driven from an ISR (the horn fast path, a playing sequence) is
+// claimed: the commit leaves its port bit alone and the ISR owns it.
+
+// Output bits
+const uint8_t OUTPUT_DRL = 0x01;
+const uint8_t OUTPUT_TAIL_LIGHT = 0x02;
+const uint8_t OUTPUT_LOW_BEAM = 0x04;
+const uint8_t OUTPUT_HIGH_BEAM = 0x08;
+const uint8_t OUTPUT_HORN = 0x10;
+const uint8_t OUTPUT_CAMERA = 0x20;
+
+// Output functions
+void setupOutputs();                        // All outputs OFF, pins configured as outputs
+void setOutput(uint8_t output, bool on);    // Takes effect at the next commit
+bool isOutputOn(uint8_t output);            // Shadow state, including uncommitted changes
+uint8_t getOutputs();                       // Shadow image (OUTPUT_* bits)
+uint8_t claimOutputs(uint8_t outputs);      // Hand outputs over to an ISR, returns the newly claimed ones
+void releaseOutputs(uint8_t outputs);       // Back to the commit, rewritten from the shadow
+void driveOutputs(uint8_t outputs, uint8_t levels); // Claimed outputs straight to the pins (interrupts off)
+void commitOutputs();
+
+#endif
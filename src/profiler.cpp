@@ -0,0 +1,125 @@
+#include "profiler.h"
+
+#if PROFILER
+#include "log.h"
+
+const char PROFILER_REPORT_REQUEST = 'P';
+const char PROFILER_RESET_REQUEST = 'R';
+const uint8_t PROFILER_BUCKETS = 8;
+
+static const uint8_t PROFILER_TICKS_PER_US = 2;             // F_CPU / 8
+static const unsigned long PROFILER_TICK_RANGE_US = 30000;  // Longer runs are timed with micros()
+static const uint8_t REPORT_LINE_MAX = 58;                  // "HIST:13,65535,...,65535\r\n"
+static const uint8_t PROFILER_SLOTS = SCHEDULER_MAX_TASKS + 1; // Tasks, then the loop
+
+struct ProfileStats {
+  unsigned long count;
+  uint64_t totalMicros;     // The loop entry alone passes 2^32 us after 72 minutes
+  uint16_t minMicros;       // Saturate at 65535 us: anything near that is a stall anyway
+  uint16_t maxMicros;
+  uint16_t buckets[PROFILER_BUCKETS];
+};
+
+static const SchedulerTask* profiledTasks = nullptr;
+static uint8_t profiledCount = 0;
+static ProfileStats profileStats[PROFILER_SLOTS];
+static uint16_t lastLoopTicks = 0;
+static unsigned long lastLoopMicros = 0;
+static bool loopStarted = false;
+static uint8_t reportCursor = 0;          // Next report line; 2 * (profiledCount + 1) = idle
+
+static void recordSample(ProfileStats& stats, unsigned long us) {
+  uint16_t clamped = us > 0xFFFF ? 0xFFFF : (uint16_t)us;
+  if (stats.count == 0 || clamped < stats.minMicros) stats.minMicros = clamped;
+  if (clamped > stats.maxMicros) stats.maxMicros = clamped;
+  stats.count++;
+  stats.totalMicros += us;
+
+  // log4 buckets: <4, <16, <64, ... us
+  uint8_t bucket = 0;
+  while (bucket < PROFILER_BUCKETS - 1 && us >= 4) {
+    us >>= 2;
+    bucket++;
+  }
+  if (stats.buckets[bucket] != 0xFFFF) stats.buckets[bucket]++;
+}
+
+static unsigned long elapsedMicros(uint16_t startTicks, unsigned long coarseMicros) {
+  // Timer1 wraps every 32.8 ms; beyond that the caller's micros() delta is used
+  if (coarseMicros >= PROFILER_TICK_RANGE_US) return coarseMicros;
+  return (uint16_t)(profilerTimestamp() - startTicks) / PROFILER_TICKS_PER_US;
+}
+
+void setupProfiler(const SchedulerTask* tasks, uint8_t count) {
+  profiledTasks = tasks;
+  profiledCount = count > SCHEDULER_MAX_TASKS ? SCHEDULER_MAX_TASKS : count;
+  reportCursor = 2 * (profiledCount + 1);
+  resetProfiler();
+}
+
+uint16_t profilerTimestamp() {
+#if defined(__AVR__)
+  return TCNT1;
+#else
+  return (uint16_t)(micros() * PROFILER_TICKS_PER_US);
+#endif
+}
+
+void profileTask(uint8_t task, uint16_t startTicks, unsigned long coarseMicros) {
+  recordSample(profileStats[task], elapsedMicros(startTicks, coarseMicros));
+}
+
+void profileLoopPass() {
+  unsigned long now = micros();
+  if (loopStarted) {
+    recordSample(profileStats[profiledCount], elapsedMicros(lastLoopTicks, now - lastLoopMicros));
+  }
+  loopStarted = true;
+  lastLoopTicks = profilerTimestamp();
+  lastLoopMicros = now;
+}
+
+void requestProfilerReport() {
+  reportCursor = 0;
+}
+
+void resetProfiler() {
+  for (uint8_t i = 0; i < PROFILER_SLOTS; i++) {
+    profileStats[i] = ProfileStats();
+  }
+  loopStarted = false;
+}
+
+void reportProfiler() {
+  // Two lines per slot, each only once the serial link has room for it
+  if (reportCursor >= 2 * (profiledCount + 1) || !canWriteDebugLine(REPORT_LINE_MAX)) return;
+
+  uint8_t slot = reportCursor / 2;
+  bool histogram = reportCursor % 2;
+  reportCursor++;
+  const ProfileStats& stats = profileStats[slot];
+
+  if (!histogram) {
+    Serial.print("PROF:");
+    Serial.print(slot);
+    Serial.print(",");
+    Serial.print(slot < profiledCount ? profiledTasks[slot].name : "loop");
+    Serial.print(",");
+    Serial.print(stats.count);
+    Serial.print(",");
+    Serial.print(stats.minMicros);
+    Serial.print(",");
+    Serial.print((unsigned long)(stats.count ? stats.totalMicros / stats.count : 0));
+    Serial.print(",");
+    Serial.println(stats.maxMicros);
+  } else {
+    Serial.print("HIST:");
+    Serial.print(slot);
+    for (uint8_t bucket = 0; bucket < PROFILER_BUCKETS; bucket++) {
+      Serial.print(",");
+      Serial.print(stats.buckets[bucket]);
+    }
+    Serial.println();
+  }
+}
+#endif
@@ -0,0 +1,39 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+// Per-task profiler: 1 = every scheduler task and the whole loop pass are
+// timed, 0 = compiled out completely (no code, no RAM).
+// Tasks are timestamped with TCNT1, which the GPS UART runs free at
+// F_CPU / 8 (0.5 us per tick), so a measurement is two register reads.
+// Each task keeps count, min, mean, max and a histogram with log4 buckets
+// (<4 us, <16 us, ... <16 ms, >= 16 ms); the loop entry measures the time
+// between passes, i.e. the loop jitter every task sees on top of its own.
+// About 32 bytes of RAM per task, so it is off by default.
+//
+// Queried over the ESP32 link: PROFILER_REPORT_REQUEST prints
+//   PROF:<index>,<task>,<count>,<min us>,<mean us>,<max us>
+//   HIST:<index>,<bucket 0>,...,<bucket 7>
+// for every task plus "loop", and PROFILER_RESET_REQUEST clears the stats.
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#if PROFILER
+extern const char PROFILER_REPORT_REQUEST;
+extern const char PROFILER_RESET_REQUEST;
+extern const uint8_t PROFILER_BUCKETS;
+
+// Profiler functions
+void setupProfiler(const SchedulerTask* tasks, uint8_t count);
+uint16_t profilerTimestamp();   // Timer1 ticks (0.5 us), wraps every 32.8 ms
+void profileTask(uint8_t task, uint16_t startTicks, unsigned long elapsedMicros);
+void profileLoopPass();         // Once per loop(), for the jitter between passes
+void requestProfilerReport();
+void resetProfiler();
+void reportProfiler();          // One line per call while a report is pending
+#endif
+
+#endif
@@ -1,136 +1,200 @@
 #include "reverse.h"
+#include "inputs.h"
+#include "telemetry.h"
+#include "log.h"
+#include "outputs.h"
+#include "fastpin.h"
+#include "timers.h"
+#include "events.h"
+
+// Reverse gear and camera button pins, resolved at compile time
+typedef FastPin<REVERSE_GEAR_PIN> ReverseGearPin;
+typedef FastPin<CAMERA_BUTTON_PIN> CameraButton;
 
 // Reverse gear configuration
-const byte REVERSE_GEAR_PIN = 3; // D3: Reverse gear switch input
-const unsigned long REVERSE_GEAR_DEBOUNCE_MS = 100;
+unsigned long REVERSE_GEAR_SETTLE_MS = 20;       // Switch bounce dies out well within 20ms
 
 // Camera configuration
-const int CAMERA_MOSFET_PIN = 4; // D4: Camera 12V MOSFET control
-const int CAMERA_BUTTON_PIN = 5; // D5: Manual camera activation button
-const unsigned long CAMERA_BUTTON_DEBOUNCE_MS = 200;
-const unsigned long CAMERA_AUTO_OFF_TIMEOUT_MS = 30000; // 30 seconds
-const unsigned long CAMERA_MANUAL_TIMEOUT_MS = 60000;   // 15 seconds
+unsigned long CAMERA_AUTO_OFF_TIMEOUT_MS = 30000;       // 30 seconds
+unsigned long CAMERA_MANUAL_TIMEOUT_MS = 60000;         // 1 minute
+
+// Delay TIMER_CAMERA_OFF was armed with, for the log: the timeouts can be
+// changed while it runs
+static unsigned long cameraOffDelayMs = 0;
 
 // Reverse gear state variables
 static bool reverseGearEngaged = false;
+
+#if REVERSE_EDGE_CAPTURE
+// Edge capture: the INT1 ISR timestamps every transition into a small ring.
+// When the ring is full the newest slot is overwritten, so the most recent
+// edge (the one settling is measured from) is never lost.
+struct ReverseEdge {
+  unsigned long timestamp;
+  uint8_t level;
+};
+static const uint8_t REVERSE_EDGE_BUFFER_SIZE = 8; // Power of two
+static volatile ReverseEdge reverseEdges[REVERSE_EDGE_BUFFER_SIZE];
+static volatile uint8_t reverseEdgeHead = 0;
+static volatile uint8_t reverseEdgeTail = 0;
+static volatile unsigned long reverseEdgeOverruns = 0;
 static uint8_t reverseLastRawReading = HIGH;
-static bool reverseStableState = HIGH;          // debounced state
 static unsigned long reverseLastChangeMillis = 0;
+static bool reverseSettling = false;
+
+static void onReverseGearEdge();
+#endif
 
 // Camera state tracking
 static bool cameraIsActive = false;
 static bool cameraActivatedByReverse = false;
 static bool cameraActivatedByButton = false;
-static unsigned long cameraStartTime = 0;
-static int cameraLastButtonState = HIGH;
-static unsigned long cameraLastDebounceTime = 0;
+
+static void onCameraTimeout();
 
 void setupReverse() {
   // Setup reverse gear detection
   // Note: Uses external voltage divider (4.7kΩ pull-up + 1kΩ series resistor)
   // When reverse engaged: switch closes, pin reads LOW through 1kΩ resistor
   // When not in reverse: switch open, pin reads HIGH through 4.7kΩ pull-up
-  pinMode(REVERSE_GEAR_PIN, INPUT);  // No internal pull-up, using external voltage divider
+  ReverseGearPin::input();  // No internal pull-up, using external voltage divider
 
   // read initial state
-  reverseLastRawReading = digitalRead(REVERSE_GEAR_PIN);
-  reverseStableState = reverseLastRawReading;
   // For reverse gear switch: LOW = reverse engaged, HIGH = not in reverse
-  reverseGearEngaged = (reverseStableState == LOW);
+  reverseGearEngaged = !ReverseGearPin::read();
 
+#if REVERSE_EDGE_CAPTURE
+  reverseLastRawReading = reverseGearEngaged ? LOW : HIGH;
   reverseLastChangeMillis = millis();
 
-  // Setup camera control
-  // Set camera relay pin as output
-  pinMode(CAMERA_MOSFET_PIN, OUTPUT);
-  digitalWrite(CAMERA_MOSFET_PIN, RELAY_OFF); // Ensure camera is off initially
+  // D3 is INT1: capture both edges
+  attachInterrupt(digitalPinToInterrupt(REVERSE_GEAR_PIN), onReverseGearEdge, CHANGE);
+#endif
 
   // Set camera button pin as input (capacitive touch button with external pull-up)
   // Capacitive touch button: GND, VCC, I/O pins
   // I/O pin connected to Arduino input, VCC to +5V, GND to ground
-  pinMode(CAMERA_BUTTON_PIN, INPUT); // No internal pull-up, capacitive button has its own pull-up
+  CameraButton::input(); // No internal pull-up, capacitive button has its own pull-up
   
   // Send initial reverse gear status
   sendReverseStatus();
 }
 
+#if REVERSE_EDGE_CAPTURE
+static void onReverseGearEdge() {
+  uint8_t head = reverseEdgeHead;
+  uint8_t next = (head + 1) & (REVERSE_EDGE_BUFFER_SIZE - 1);
+  if (next == reverseEdgeTail) {
+    // Ring full: overwrite the newest entry
+    head = (head - 1) & (REVERSE_EDGE_BUFFER_SIZE - 1);
+    next = reverseEdgeHead;
+    reverseEdgeOverruns++;
+  }
+  reverseEdges[head].timestamp = millis();
+  reverseEdges[head].level = ReverseGearPin::read() ? HIGH : LOW;
+  reverseEdgeHead = next;
+}
+#endif
+
+bool isReverseGearPending() {
+#if REVERSE_EDGE_CAPTURE
+  // Run when edges are queued or when the last edge has settled
+  return reverseEdgeHead != reverseEdgeTail ||
+         (reverseSettling && millis() - reverseLastChangeMillis >= REVERSE_GEAR_SETTLE_MS);
+#else
+  // Polled mode: run when the input debouncer reports an edge on D3
+  return (peekInputEdges() & inputMask(REVERSE_GEAR_PIN)) != 0;
+#endif
+}
+
 void handleReverse() {
-  // Handle reverse gear detection
-  uint8_t raw = digitalRead(REVERSE_GEAR_PIN);
+#if REVERSE_EDGE_CAPTURE
+  // Consume captured edges; the last one gives the current line level
+  while (reverseEdgeTail != reverseEdgeHead) {
+    noInterrupts();
+    uint8_t tail = reverseEdgeTail;
+    reverseLastChangeMillis = reverseEdges[tail].timestamp;
+    reverseLastRawReading = reverseEdges[tail].level;
+    reverseEdgeTail = (tail + 1) & (REVERSE_EDGE_BUFFER_SIZE - 1);
+    interrupts();
+    reverseSettling = true;
+  }
 
-  // if input changed, reset timer
-  if (raw != reverseLastRawReading) {
-    reverseLastChangeMillis = millis();
-    reverseLastRawReading = raw;
-  } else {
-    // if stable long enough and different from stable state → update
-    if (raw != reverseStableState && (millis() - reverseLastChangeMillis >= REVERSE_GEAR_DEBOUNCE_MS)) {
-      reverseStableState = raw;
-      // For reverse gear switch: LOW = reverse engaged, HIGH = not in reverse
-      reverseGearEngaged = (reverseStableState == LOW);
-
-      // Send reverse status immediately when state change is stable
-      sendReverseStatus();
-
-      // Handle camera activation based on reverse gear
-      if (reverseGearEngaged) {
-        activateCameraByReverse();
-      } else {
-        deactivateCameraByReverse();
-      }
-      
-      // Reset the debounce timer after state change to prevent immediate re-triggering
-      reverseLastChangeMillis = millis();
-    }
+  // Line quiet for the settle time → accept the level
+  if (!reverseSettling || millis() - reverseLastChangeMillis < REVERSE_GEAR_SETTLE_MS) {
+    return;
   }
+  reverseSettling = false;
+  // For reverse gear switch: LOW = reverse engaged, HIGH = not in reverse
+  bool engaged = (reverseLastRawReading == LOW);
+#else
+  // Debounced edges from the shared input debouncer
+  uint8_t mask = inputMask(REVERSE_GEAR_PIN);
+  takeInputPresses(mask);
+  takeInputReleases(mask);
+  bool engaged = (getDebouncedInputs() & mask) == 0;
+#endif
+
+  if (engaged == reverseGearEngaged) {
+    return; // Bounced back to the previous state
+  }
+  reverseGearEngaged = engaged;
 
-  // Handle manual camera button
-  int buttonState = digitalRead(CAMERA_BUTTON_PIN);
+  // Send reverse status immediately when state change is stable
+  sendReverseStatus();
 
-  // If the switch changed, due to noise or pressing:
-  if (buttonState != cameraLastButtonState) {
-    // reset the debouncing timer
-    cameraLastDebounceTime = millis();
-  }
+  // The camera reacts to the event
+  postEvent(EVENT_REVERSE_CHANGED, reverseGearEngaged);
+}
+
+unsigned long getReverseEdgeOverruns() {
+#if REVERSE_EDGE_CAPTURE
+  noInterrupts();
+  unsigned long overruns = reverseEdgeOverruns;
+  interrupts();
+  return overruns;
+#else
+  return 0;
+#endif
+}
 
-  if ((millis() - cameraLastDebounceTime) > CAMERA_BUTTON_DEBOUNCE_MS) {
-    // Check if the capacitive touch button is touched (HIGH) and camera is not currently active
-    // Note: This capacitive touch button reads HIGH when touched, LOW when not touched
-    if (buttonState == HIGH && !cameraIsActive) {
-      cameraIsActive = true;
-      cameraActivatedByButton = true;
-      cameraActivatedByReverse = false;
-      cameraStartTime = millis();
-      digitalWrite(CAMERA_MOSFET_PIN, RELAY_ON);
-      Serial.println("Camera activated by capacitive touch button!");
+void onCameraEvent(const Event& event) {
+  // Camera activation based on reverse gear
+  if (event.type == EVENT_REVERSE_CHANGED) {
+    if (event.arg) {
+      activateCameraByReverse();
+    } else {
+      deactivateCameraByReverse();
     }
+    return;
   }
 
-  // Handle camera timeout logic
-  if (cameraIsActive) {
-    unsigned long elapsedTime = millis() - cameraStartTime;
-    bool shouldTurnOff = false;
-
-    if (cameraActivatedByButton && elapsedTime >= CAMERA_MANUAL_TIMEOUT_MS) {
-      // Manual activation timeout (15 seconds)
-      shouldTurnOff = true;
-      Serial.println("Camera turned off - manual timeout (15 seconds)");
-    } else if (!cameraActivatedByReverse && !cameraActivatedByButton && elapsedTime >= CAMERA_AUTO_OFF_TIMEOUT_MS) {
-      // Auto-off timeout (1 minute) - only if not activated by reverse or button
-      shouldTurnOff = true;
-      Serial.println("Camera turned off - auto timeout (1 minute)");
-    }
+  // Handle manual camera button
+  // Note: This capacitive touch button reads HIGH when touched, LOW when not touched
+  if (takeInputPresses(inputMask(CAMERA_BUTTON_PIN)) && !cameraIsActive) {
+    cameraIsActive = true;
+    cameraActivatedByButton = true;
+    cameraActivatedByReverse = false;
+    cameraOffDelayMs = CAMERA_MANUAL_TIMEOUT_MS;
+    armTimer(TIMER_CAMERA_OFF, cameraOffDelayMs, onCameraTimeout);
+    setOutput(OUTPUT_CAMERA, true);
+    logEvent(LOG_EVENT_CAMERA_ON_BUTTON);
+  }
+}
 
-    if (shouldTurnOff) {
-      cameraIsActive = false;
-      cameraActivatedByButton = false;
-      cameraActivatedByReverse = false;
-      digitalWrite(CAMERA_MOSFET_PIN, RELAY_OFF);
-    }
+static void onCameraTimeout() {
+  // Manual activation timeout, or auto-off after reverse gear was disengaged
+  // (never armed while the camera is held on by reverse gear)
+  if (cameraActivatedByButton) {
+    logEvent(LOG_EVENT_CAMERA_OFF_MANUAL, (int32_t)cameraOffDelayMs);
+  } else {
+    logEvent(LOG_EVENT_CAMERA_OFF_AUTO, (int32_t)cameraOffDelayMs);
   }
 
-  // Save the reading. Next time through the loop, it'll be the lastButtonState:
-  cameraLastButtonState = buttonState;
+  cameraIsActive = false;
+  cameraActivatedByButton = false;
+  cameraActivatedByReverse = false;
+  setOutput(OUTPUT_CAMERA, false);
 }
 
 bool isReverseGearEngaged() {
@@ -143,16 +207,15 @@ void activateCameraByReverse() {
     cameraIsActive = true;
     cameraActivatedByReverse = true;
     cameraActivatedByButton = false;
-    cameraStartTime = millis();
-    digitalWrite(CAMERA_MOSFET_PIN, RELAY_ON);
-    Serial.println("Camera activated by reverse gear!");
+    setOutput(OUTPUT_CAMERA, true);
+    logEvent(LOG_EVENT_CAMERA_ON_REVERSE);
   } else {
     // Camera is already active (e.g., counting down from previous disengagement)
     // Reset it to reverse-activated mode to cancel any countdown
     cameraActivatedByReverse = true;
     cameraActivatedByButton = false;
-    cameraStartTime = millis(); // Reset timer
-    Serial.println("Camera reactivated by reverse gear (was counting down)!");
+    cancelTimer(TIMER_CAMERA_OFF);
+    logEvent(LOG_EVENT_CAMERA_ON_REVERSE_AGAIN);
   }
 }
 
@@ -160,8 +223,9 @@ void deactivateCameraByReverse() {
   if (cameraActivatedByReverse) {
     // Reverse gear disengaged - start timeout countdown to turn off camera
     cameraActivatedByReverse = false;
-    cameraStartTime = millis(); // Reset timer for auto-off
-    Serial.println("Reverse gear disengaged - camera will turn off in 30 seconds");
+    cameraOffDelayMs = CAMERA_AUTO_OFF_TIMEOUT_MS;
+    armTimer(TIMER_CAMERA_OFF, cameraOffDelayMs, onCameraTimeout); // Countdown to auto-off
+    logEvent(LOG_EVENT_CAMERA_COUNTDOWN, (int32_t)cameraOffDelayMs);
   }
 }
 
@@ -170,10 +234,6 @@ bool isCameraActive() {
 }
 
 void sendReverseStatus() {
-  // Send current reverse gear status in KEY:VALUE format
-  if (reverseGearEngaged) {
-    Serial.println("REVERSE:1");
-  } else {
-    Serial.println("REVERSE:0");
-  }
+  // Send current reverse gear status with the next telemetry tick
+  publishState(TELEMETRY_STATE_REVERSE, reverseGearEngaged);
 }
@@ -2,26 +2,34 @@
 #define REVERSE_H
 
 #include <Arduino.h>
+#include "events.h"
 #include "relay_config.h"
 
+// Reverse gear detection mode: 1 = INT1 edge capture, 0 = shared input debouncer
+#ifndef REVERSE_EDGE_CAPTURE
+#define REVERSE_EDGE_CAPTURE 1
+#endif
+
 // Reverse gear configuration
-extern const byte REVERSE_GEAR_PIN;
-extern const unsigned long REVERSE_GEAR_DEBOUNCE_MS;
+constexpr uint8_t REVERSE_GEAR_PIN = 3; // D3: Reverse gear switch input
+extern unsigned long REVERSE_GEAR_SETTLE_MS;          // Edge capture mode: quiet time after the last edge
 
 // Camera configuration
-extern const int CAMERA_MOSFET_PIN;
-extern const int CAMERA_BUTTON_PIN;
-extern const unsigned long CAMERA_BUTTON_DEBOUNCE_MS;
-extern const unsigned long CAMERA_AUTO_OFF_TIMEOUT_MS;
-extern const unsigned long CAMERA_MANUAL_TIMEOUT_MS;
+constexpr uint8_t CAMERA_MOSFET_PIN = 4; // D4: Camera 12V MOSFET control
+constexpr uint8_t CAMERA_BUTTON_PIN = 5; // D5: Manual camera activation button
+extern unsigned long CAMERA_AUTO_OFF_TIMEOUT_MS;
+extern unsigned long CAMERA_MANUAL_TIMEOUT_MS;
 
 // Reverse gear functions
 void setupReverse();
 void handleReverse();
+bool isReverseGearPending();
 bool isReverseGearEngaged();
+unsigned long getReverseEdgeOverruns();
 void sendReverseStatus();
 
 // Camera functions
+void onCameraEvent(const Event& event);   // Reverse gear changes and button edges
 void activateCameraByReverse();
 void deactivateCameraByReverse();
 bool isCameraActive();
@@ -0,0 +1,186 @@
+#include "scheduler.h"
+#include "log.h"
+#include "profiler.h"
+
+// Scheduler configuration
+const unsigned long SCHEDULER_REPORT_INTERVAL_MS = 10000; // Report period usage every 10 seconds
+
+// Room needed for one report line ("SCHED:headlights,20000,100000,100.0,100.00,9999\r\n")
+static const uint8_t REPORT_LINE_MAX = 48;
+
+// Per-task runtime state
+struct TaskState {
+  bool pending;                // Released and waiting to run
+  unsigned long nextRelease;   // Periodic tasks: next release time
+  unsigned long releaseTime;   // When the pending job was released
+  unsigned long runs;          // Jobs run in the current report window
+  unsigned long busyMicros;    // Time spent running in the current report window
+  unsigned long maxMicros;     // Longest job in the current report window
+  unsigned long deadlineMisses;
+};
+
+static const SchedulerTask* taskTable = nullptr;
+static uint8_t taskCount = 0;
+static uint8_t taskOrder[SCHEDULER_MAX_TASKS]; // Task indices, most urgent first
+static TaskState taskStates[SCHEDULER_MAX_TASKS];
+static unsigned long windowStartMicros = 0;
+static unsigned long lastReportTime = 0;
+static uint8_t reportCursor = 0;             // Next task line of the report; taskCount = idle
+static unsigned long reportWindowMicros = 0;
+
+void setupScheduler(const SchedulerTask* tasks, uint8_t count) {
+  taskTable = tasks;
+  taskCount = count > SCHEDULER_MAX_TASKS ? SCHEDULER_MAX_TASKS : count;
+
+  // Order tasks by priority (insertion sort, table is tiny)
+  for (uint8_t i = 0; i < taskCount; i++) {
+    uint8_t j = i;
+    while (j > 0 && taskTable[taskOrder[j - 1]].priority > taskTable[i].priority) {
+      taskOrder[j] = taskOrder[j - 1];
+      j--;
+    }
+    taskOrder[j] = i;
+  }
+
+  // Release every periodic task on the first pass
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < taskCount; i++) {
+    taskStates[i] = TaskState();
+    taskStates[i].nextRelease = now;
+  }
+
+  windowStartMicros = micros();
+  lastReportTime = now;
+  reportCursor = taskCount;
+
+#if PROFILER
+  setupProfiler(tasks, taskCount);
+#endif
+}
+
+void runScheduler() {
+  unsigned long now = millis();
+
+  // Release due jobs
+  for (uint8_t i = 0; i < taskCount; i++) {
+    const SchedulerTask& task = taskTable[i];
+    TaskState& state = taskStates[i];
+    if (state.pending) continue;
+
+    if (task.ready != nullptr) {
+      if (task.ready()) {
+        state.pending = true;
+        state.releaseTime = now;
+      }
+    } else if ((long)(now - state.nextRelease) >= 0) {
+      state.pending = true;
+      state.releaseTime = state.nextRelease;
+      state.nextRelease += task.periodMs;
+      // Fell more than a period behind: skip the missed releases instead of bursting
+      if ((long)(now - state.nextRelease) >= 0) {
+        state.nextRelease = now + task.periodMs;
+      }
+    }
+  }
+
+  // Run the most urgent pending job
+  for (uint8_t k = 0; k < taskCount; k++) {
+    uint8_t i = taskOrder[k];
+    TaskState& state = taskStates[i];
+    if (!state.pending) continue;
+
+    state.pending = false;
+    if (now - state.releaseTime > taskTable[i].deadlineMs) {
+      state.deadlineMisses++;
+    }
+
+    unsigned long start = micros();
+#if PROFILER
+    uint16_t startTicks = profilerTimestamp();
+#endif
+    taskTable[i].run();
+    unsigned long elapsed = micros() - start;
+#if PROFILER
+    profileTask(i, startTicks, elapsed);
+#endif
+
+    state.runs++;
+    state.busyMicros += elapsed;
+    if (elapsed > state.maxMicros) state.maxMicros = elapsed;
+    break;
+  }
+
+#if PROFILER
+  reportProfiler();
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  if (SCHEDULER_REPORT_INTERVAL_MS > 0 && millis() - lastReportTime >= SCHEDULER_REPORT_INTERVAL_MS &&
+      reportCursor == taskCount) {
+    // Close the window; the lines go out one by one as the serial link has room
+    unsigned long nowMicros = micros();
+    reportWindowMicros = nowMicros - windowStartMicros;
+    if (reportWindowMicros == 0) reportWindowMicros = 1;
+    windowStartMicros = nowMicros;
+    reportCursor = 0;
+    lastReportTime = millis();
+  }
+  if (reportCursor < taskCount && canWriteDebugLine(REPORT_LINE_MAX)) {
+    reportSchedulerStats();
+  }
+#endif
+}
+
+unsigned long millisUntilNextTask() {
+  // Event-driven tasks can only say whether they are ready now; a deadline
+  // they wait for (e.g. the timers task) has to be added by the caller
+  unsigned long now = millis();
+  unsigned long next = (unsigned long)-1;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    const SchedulerTask& task = taskTable[i];
+    const TaskState& state = taskStates[i];
+    if (state.pending) return 0;
+    if (task.ready != nullptr) {
+      if (task.ready()) return 0;
+      continue;
+    }
+    long until = (long)(state.nextRelease - now);
+    if (until <= 0) return 0;
+    if ((unsigned long)until < next) next = (unsigned long)until;
+  }
+  return next;
+}
+
+void reportSchedulerStats() {
+  // SCHED:<task>,<runs>,<max us>,<max % of period>,<load %>,<deadline misses>
+  // Load is the share of the report window the task spent running. One task
+  // per call, so the report never fills the TX buffer and blocks loop(); a
+  // task's counters restart when its line has been printed.
+  if (reportCursor >= taskCount) return;
+
+  uint8_t i = taskOrder[reportCursor++];
+  const SchedulerTask& task = taskTable[i];
+  TaskState& state = taskStates[i];
+
+  Serial.print("SCHED:");
+  Serial.print(task.name);
+  Serial.print(",");
+  Serial.print(state.runs);
+  Serial.print(",");
+  Serial.print(state.maxMicros);
+  Serial.print(",");
+  if (task.periodMs > 0) {
+    Serial.print(state.maxMicros * 100.0 / (task.periodMs * 1000.0), 1);
+  } else {
+    Serial.print("-");
+  }
+  Serial.print(",");
+  Serial.print(state.busyMicros * 100.0 / reportWindowMicros, 2);
+  Serial.print(",");
+  Serial.println(state.deadlineMisses);
+
+  // Start a new window
+  state.runs = 0;
+  state.busyMicros = 0;
+  state.maxMicros = 0;
+}
@@ -0,0 +1,26 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative tick scheduler configuration
+constexpr uint8_t SCHEDULER_MAX_TASKS = 16;  // Also sizes the profiler
+extern const unsigned long SCHEDULER_REPORT_INTERVAL_MS; // How often period usage is reported (0 = never)
+
+// One entry of the static task table
+struct SchedulerTask {
+  const char* name;
+  void (*run)();
+  bool (*ready)();          // Event-driven tasks: released whenever this returns true (nullptr = periodic)
+  unsigned long periodMs;   // Periodic tasks: release period
+  unsigned long deadlineMs; // Release-to-start latency allowed before a deadline miss is counted
+  uint8_t priority;         // 0 = most urgent
+};
+
+// Scheduler functions
+void setupScheduler(const SchedulerTask* tasks, uint8_t count);   // count <= SCHEDULER_MAX_TASKS (static_assert in main.cpp)
+void runScheduler();
+unsigned long millisUntilNextTask();   // 0 = a job is ready; how long the loop could sleep (or a host replay skip)
+void reportSchedulerStats();
+
+#endif
@@ -0,0 +1,216 @@
+#include "sequence.h"
+#include "log.h"
+#include "outputs.h"
+
+#if !defined(__AVR__)
+#include <sim.h>
+#endif
+
+// Sequence configuration
+const uint8_t SEQUENCE_TICK_MS = 1;
+
+// Beam flash timing (relay-friendly)
+static const uint16_t BEAM_FLASH_DURATION_MS = 300;
+static const uint16_t BEAM_FLASH_PAUSE_MS = 200;
+
+// Passing flash: two 300 ms high beam flashes, low beam in between with a
+// short gap (both off) before the second flash
+static const SequenceStep PASSING_FLASH_STEPS[] PROGMEM = {
+  {OUTPUT_HIGH_BEAM, BEAM_FLASH_DURATION_MS},
+  {OUTPUT_LOW_BEAM,  BEAM_FLASH_DURATION_MS + 2 * BEAM_FLASH_PAUSE_MS},
+  {0,                BEAM_FLASH_PAUSE_MS},
+  {OUTPUT_HIGH_BEAM, BEAM_FLASH_DURATION_MS},
+  {OUTPUT_LOW_BEAM,  BEAM_FLASH_DURATION_MS + BEAM_FLASH_PAUSE_MS},
+  {0, 0},
+};
+
+// Hazard: DRL and tail lights together, 5 blinks at ~1.25 Hz
+static const SequenceStep HAZARD_STEPS[] PROGMEM = {
+  {OUTPUT_DRL | OUTPUT_TAIL_LIGHT, 400}, {0, 400},
+  {OUTPUT_DRL | OUTPUT_TAIL_LIGHT, 400}, {0, 400},
+  {OUTPUT_DRL | OUTPUT_TAIL_LIGHT, 400}, {0, 400},
+  {OUTPUT_DRL | OUTPUT_TAIL_LIGHT, 400}, {0, 400},
+  {OUTPUT_DRL | OUTPUT_TAIL_LIGHT, 400}, {0, 400},
+  {0, 0},
+};
+
+// Horn chirp: two pulses just long enough for the relay to close
+static const SequenceStep HORN_CHIRP_STEPS[] PROGMEM = {
+  {OUTPUT_HORN, 60}, {0, 100},
+  {OUTPUT_HORN, 60},
+  {0, 0},
+};
+
+// Names for the serial PLAY command
+static const char PASSING_FLASH_NAME[] PROGMEM = "FLASH";
+static const char HAZARD_NAME[] PROGMEM = "HAZARD";
+static const char HORN_CHIRP_NAME[] PROGMEM = "CHIRP";
+
+struct SequencePatternInfo {
+  const SequenceStep* steps;
+  uint8_t outputs;  // Outputs the pattern drives (claimed while it plays)
+  PGM_P name;
+};
+
+static const SequencePatternInfo SEQUENCE_PATTERN_TABLE[SEQUENCE_PATTERNS] PROGMEM = {
+  {PASSING_FLASH_STEPS, OUTPUT_LOW_BEAM | OUTPUT_HIGH_BEAM, PASSING_FLASH_NAME},
+  {HAZARD_STEPS,        OUTPUT_DRL | OUTPUT_TAIL_LIGHT,     HAZARD_NAME},
+  {HORN_CHIRP_STEPS,    OUTPUT_HORN,                        HORN_CHIRP_NAME},
+};
+
+// Player state, advanced by the timer interrupt
+static const SequenceStep* volatile nextStep = nullptr;
+static volatile uint16_t stepTicksLeft = 0;
+static volatile uint8_t sequenceOutputs = 0;   // The pattern's outputs this player owns
+static volatile bool sequenceFinished = false;
+static volatile unsigned long sequenceEndTime = 0;
+
+// Loop side
+static uint8_t playingPattern = SEQUENCE_PATTERNS;  // SEQUENCE_PATTERNS = none
+static uint8_t ownedOutputs = 0;                     // Claimed by startSequence(), released when done
+static unsigned long sequenceStartTime = 0;
+
+static void stopSequenceTimer();
+
+static void onSequenceTick(unsigned long now) {
+  if (sequenceFinished) return;
+  if (stepTicksLeft > 1) {
+    stepTicksLeft--;
+    return;
+  }
+
+  const SequenceStep* step = nextStep;
+  uint16_t durationMs = pgm_read_word(&step->durationMs);
+  if (durationMs == 0) {
+    // Back to what the modules want now, then the loop releases the outputs
+    driveOutputs(sequenceOutputs, getOutputs());
+    stopSequenceTimer();
+    sequenceEndTime = now;
+    sequenceFinished = true;
+    return;
+  }
+
+  driveOutputs(sequenceOutputs, pgm_read_byte(&step->outputs));
+  stepTicksLeft = durationMs / SEQUENCE_TICK_MS;
+  nextStep = step + 1;
+}
+
+#if defined(__AVR__)
+ISR(TIMER2_COMPA_vect) {
+  onSequenceTick(millis());
+}
+
+static void startSequenceTimer() {
+  // First tick one full period from now
+  TCNT2 = 0;
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 |= _BV(OCIE2A);
+}
+
+static void stopSequenceTimer() {
+  TIMSK2 &= ~_BV(OCIE2A);
+}
+
+static inline void updateSequences() {}
+#else
+// Host model of Timer2: the ticks are replayed from the virtual clock
+// whenever the loop looks at the sequence state
+static bool simTimerRunning = false;
+static uint64_t simNextTickMicros = 0;
+
+static void startSequenceTimer() {
+  simTimerRunning = true;
+  simNextTickMicros = simMicros() + (uint64_t)SEQUENCE_TICK_MS * 1000;
+}
+
+static void stopSequenceTimer() {
+  simTimerRunning = false;
+}
+
+static void updateSequences() {
+  uint64_t now = simMicros();
+  while (simTimerRunning && simNextTickMicros <= now) {
+    onSequenceTick((unsigned long)(simNextTickMicros / 1000));
+    simNextTickMicros += (uint64_t)SEQUENCE_TICK_MS * 1000;
+  }
+}
+#endif
+
+void setupSequences() {
+  playingPattern = SEQUENCE_PATTERNS;
+  ownedOutputs = 0;
+  sequenceFinished = false;
+
+#if defined(__AVR__)
+  // Timer2 in CTC mode, 16 MHz / 64 / 250 = 1 kHz; the interrupt is only
+  // enabled while a pattern plays
+  TIMSK2 = 0;
+  TCCR2A = _BV(WGM21);
+  TCCR2B = _BV(CS22);
+  OCR2A = (F_CPU / 64 / 1000) * SEQUENCE_TICK_MS - 1;
+#else
+  simTimerRunning = false;
+#endif
+}
+
+bool startSequence(uint8_t pattern) {
+  if (pattern >= SEQUENCE_PATTERNS || playingPattern != SEQUENCE_PATTERNS) return false;
+
+  const SequencePatternInfo* info = &SEQUENCE_PATTERN_TABLE[pattern];
+  uint8_t outputs = pgm_read_byte(&info->outputs);
+
+  // Outputs already owned by another ISR (horn fast path) stay with it and
+  // are never driven from here; a pattern left with none of its outputs
+  // does not play
+  uint8_t claimed = claimOutputs(outputs);
+  if (claimed == 0) return false;
+  ownedOutputs = claimed;
+  playingPattern = pattern;
+  sequenceStartTime = millis();
+
+  noInterrupts();
+  nextStep = (const SequenceStep*)pgm_read_ptr(&info->steps);
+  stepTicksLeft = 0;
+  sequenceOutputs = claimed;
+  sequenceFinished = false;
+  interrupts();
+
+  startSequenceTimer();
+  return true;
+}
+
+uint8_t findSequencePattern(const char* name) {
+  uint8_t pattern = 0;
+  while (pattern < SEQUENCE_PATTERNS && strcmp_P(name, getSequencePatternName(pattern)) != 0) pattern++;
+  return pattern;
+}
+
+PGM_P getSequencePatternName(uint8_t pattern) {
+  return (PGM_P)pgm_read_ptr(&SEQUENCE_PATTERN_TABLE[pattern].name);
+}
+
+bool isSequencePlaying() {
+  updateSequences();
+  return playingPattern != SEQUENCE_PATTERNS;
+}
+
+bool isSequenceFinished() {
+  updateSequences();
+  return sequenceFinished;
+}
+
+void handleSequences() {
+  noInterrupts();
+  bool finished = sequenceFinished;
+  unsigned long endTime = sequenceEndTime;
+  interrupts();
+  if (!finished) return;
+
+  releaseOutputs(ownedOutputs);
+  ownedOutputs = 0;
+  sequenceFinished = false;
+
+  // Duration as played by the timer, to check the patterns for jitter
+  logEvent(LOG_EVENT_SEQUENCE_DONE, playingPattern, (int32_t)(endTime - sequenceStartTime));
+  playingPattern = SEQUENCE_PATTERNS;
+}
@@ -0,0 +1,44 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <Arduino.h>
+
+// Timed output sequences (beam flashing, hazard blinking, horn chirps).
+// A pattern is a step table in PROGMEM: which of its outputs are on, and for
+// how long. Timer2 ticks every millisecond while a pattern plays and its
+// compare interrupt advances the steps and writes the relay pins directly,
+// so the timing does not depend on the loop, serial output or other tasks.
+//
+// The outputs a pattern drives are claimed from the outputs commit while it
+// plays. Modules keep updating the shadow as usual, and the last tick drives
+// the pins back to the shadow state: whatever was on before the sequence
+// (e.g. the beam mode before a flash) comes back by itself. Outputs another
+// ISR already owns are left alone: the horn chirp does not play while the
+// horn fast path owns the horn relay.
+
+enum SequencePattern : uint8_t {
+  SEQUENCE_PASSING_FLASH,  // High beam flashes
+  SEQUENCE_HAZARD,         // DRL and tail lights blinking together
+  SEQUENCE_HORN_CHIRP,     // Two short horn pulses
+  SEQUENCE_PATTERNS
+};
+
+// One step of a pattern
+struct SequenceStep {
+  uint8_t outputs;      // OUTPUT_* bits on during this step (others of the pattern off)
+  uint16_t durationMs;  // 0 ends the pattern
+};
+
+// Sequence configuration
+extern const uint8_t SEQUENCE_TICK_MS;  // Timer2 tick while a pattern plays
+
+// Sequence functions
+void setupSequences();
+bool startSequence(uint8_t pattern);  // false if a pattern is already playing or its outputs are taken
+uint8_t findSequencePattern(const char* name);  // By name ("FLASH", "HAZARD", "CHIRP"), SEQUENCE_PATTERNS if none
+PGM_P getSequencePatternName(uint8_t pattern);
+bool isSequencePlaying();
+bool isSequenceFinished();            // Scheduler ready check: a pattern ended
+void handleSequences();               // Hands the outputs back to the commit
+
+#endif
@@ -0,0 +1,323 @@
+#include "telemetry.h"
+#include "log.h"
+
+// Telemetry configuration
+const unsigned long TELEMETRY_INTERVAL_MS = 10;
+unsigned long TELEMETRY_KEYFRAME_INTERVAL_MS = 10000;
+const char TELEMETRY_KEYFRAME_REQUEST = 'K';
+
+static const uint8_t FRAME_TYPE_DELTA = 0x01;
+static const uint8_t FRAME_TYPE_KEYFRAME = 0x02;
+
+// Field mask bits
+static const uint8_t FIELD_STATE = 0x01;
+static const uint8_t FIELD_SPEED = 0x02;
+static const uint8_t FIELD_LOCATION = 0x04;
+static const uint8_t FIELD_TTFF = 0x08;
+static const uint8_t FIELD_LOCATION_DELTA = 0x10;  // Wire only: LOCATION sent as offsets
+
+static const uint8_t ALL_STATE_BITS = TELEMETRY_STATE_REVERSE | TELEMETRY_STATE_DRL | TELEMETRY_STATE_LOW_BEAM |
+                                      TELEMETRY_STATE_HIGH_BEAM | TELEMETRY_STATE_TAIL_LIGHT;
+
+// Largest frame: header (3) + fields (1 + 2 + 8 + 4) + CRC (2)
+static const uint8_t MAX_FRAME_SIZE = 20;
+
+// Longest text line ("LOCATION:-180.000000,-180.000000\r\n")
+static const uint8_t MAX_TEXT_LINE = 34;
+
+static TelemetryFormat telemetryFormat = TELEMETRY_BINARY ? TELEMETRY_FRAMES : TELEMETRY_TEXT;
+static uint8_t frameSequence = 0;
+
+// Latest published values
+static uint8_t publishedFields = 0;  // Fields that have ever been published
+static uint8_t stateBits = 0;
+static uint16_t speed = 0;
+static int32_t latitude = 0;
+static int32_t longitude = 0;
+static uint32_t timeToFirstFix = 0;
+
+// The ESP32's view: values as last sent
+static uint8_t sentStateBits = 0;
+static uint16_t sentSpeed = 0;
+static int32_t sentLatitude = 0;
+static int32_t sentLongitude = 0;
+static uint32_t sentTimeToFirstFix = 0;
+
+// Fields and state bits to send even if unchanged: a keyframe in progress,
+// or a field's first value
+static uint8_t forcedFields = 0;
+static uint8_t forcedStateBits = 0;
+static bool keyframeDue = false;
+static bool keyframeRequested = true;  // The first tick after boot sends everything
+static unsigned long lastKeyframeTime = 0;
+
+void setupTelemetry() {
+  // Values published before this point (e.g. initial states) are kept and
+  // go out with the boot keyframe
+  frameSequence = 0;
+  keyframeRequested = true;
+}
+
+void setTelemetryFormat(TelemetryFormat format) {
+  telemetryFormat = format;
+  keyframeRequested = true;
+}
+
+TelemetryFormat getTelemetryFormat() {
+  return telemetryFormat;
+}
+
+void requestTelemetryKeyframe() {
+  keyframeRequested = true;
+}
+
+static void markPublished(uint8_t field) {
+  // A field's first value goes out even if it equals the zero-initialised snapshot
+  if (!(publishedFields & field)) forcedFields |= field;
+  publishedFields |= field;
+}
+
+void publishState(uint8_t bit, bool on) {
+  stateBits = on ? (stateBits | bit) : (stateBits & ~bit);
+  if (!(publishedFields & FIELD_STATE)) forcedStateBits |= ALL_STATE_BITS;
+  markPublished(FIELD_STATE);
+}
+
+void publishSpeed(uint32_t speedCentiKmh) {
+  speed = speedCentiKmh > 0xFFFF ? 0xFFFF : (uint16_t)speedCentiKmh;
+  markPublished(FIELD_SPEED);
+}
+
+void publishLocation(int32_t latitudeE6, int32_t longitudeE6) {
+  latitude = latitudeE6;
+  longitude = longitudeE6;
+  markPublished(FIELD_LOCATION);
+}
+
+void publishTimeToFirstFix(uint32_t ms) {
+  timeToFirstFix = ms;
+  markPublished(FIELD_TTFF);
+}
+
+// State bits that differ from the ESP32's view or belong to a keyframe
+static uint8_t pendingStateBits() {
+  if (!(publishedFields & FIELD_STATE)) return 0;
+  return ((stateBits ^ sentStateBits) | forcedStateBits) & ALL_STATE_BITS;
+}
+
+// Fields that differ from the ESP32's view or belong to a keyframe
+static uint8_t pendingFields() {
+  uint8_t fields = forcedFields;
+  if (pendingStateBits()) fields |= FIELD_STATE;
+  if (speed != sentSpeed) fields |= FIELD_SPEED;
+  if (latitude != sentLatitude || longitude != sentLongitude) fields |= FIELD_LOCATION;
+  if (timeToFirstFix != sentTimeToFirstFix) fields |= FIELD_TTFF;
+  return fields & publishedFields;
+}
+
+// ---------------------------------------------------------------------------
+// Text format
+// ---------------------------------------------------------------------------
+
+// Print a fixed-point value with the given number of decimals (no float formatting)
+static void printFixedPoint(int32_t value, uint8_t decimals) {
+  if (value < 0) {
+    Serial.print('-');
+    value = -value;
+  }
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+  Serial.print((uint32_t)value / scale);
+  Serial.print('.');
+  uint32_t fraction = (uint32_t)value % scale;
+  for (uint32_t digit = scale / 10; digit > 1 && fraction < digit; digit /= 10) {
+    Serial.print('0');
+  }
+  Serial.print(fraction);
+}
+
+static bool hasRoomForLine() {
+  return Serial.availableForWrite() >= MAX_TEXT_LINE;
+}
+
+static bool printStateLine(const char* key, uint8_t bit, uint8_t pendingBits) {
+  if (!(pendingBits & bit)) return true;
+  if (!hasRoomForLine()) return false;
+  Serial.print(key);
+  Serial.println((stateBits & bit) ? "1" : "0");
+  sentStateBits = (sentStateBits & ~bit) | (stateBits & bit);
+  forcedStateBits &= ~bit;
+  return true;
+}
+
+static void sendText(uint8_t fields) {
+  // One line at a time while the TX buffer has room; whatever does not fit
+  // stays pending for the next tick
+  if (fields & FIELD_STATE) {
+    uint8_t bits = pendingStateBits();
+    if (!printStateLine("REVERSE:", TELEMETRY_STATE_REVERSE, bits)) return;
+    if (!printStateLine("DRL:", TELEMETRY_STATE_DRL, bits)) return;
+    if (!printStateLine("TAIL_LIGHT:", TELEMETRY_STATE_TAIL_LIGHT, bits)) return;
+    if (!printStateLine("LOWBEAM:", TELEMETRY_STATE_LOW_BEAM, bits)) return;
+    if (!printStateLine("HIGHBEAM:", TELEMETRY_STATE_HIGH_BEAM, bits)) return;
+    forcedFields &= ~FIELD_STATE;
+  }
+  if (fields & FIELD_SPEED) {
+    if (!hasRoomForLine()) return;
+    Serial.print("SPEED:");
+    printFixedPoint(speed, 2);
+    Serial.println();
+    sentSpeed = speed;
+    forcedFields &= ~FIELD_SPEED;
+  }
+  if (fields & FIELD_LOCATION) {
+    if (!hasRoomForLine()) return;
+    Serial.print("LOCATION:");
+    printFixedPoint(latitude, 6);
+    Serial.print(",");
+    printFixedPoint(longitude, 6);
+    Serial.println();
+    sentLatitude = latitude;
+    sentLongitude = longitude;
+    forcedFields &= ~FIELD_LOCATION;
+  }
+  if (fields & FIELD_TTFF) {
+    if (!hasRoomForLine()) return;
+    Serial.print("GPS_TTFF:");
+    Serial.println(timeToFirstFix);
+    sentTimeToFirstFix = timeToFirstFix;
+    forcedFields &= ~FIELD_TTFF;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Binary format
+// ---------------------------------------------------------------------------
+
+static uint16_t crc16(const uint8_t* data, uint8_t length) {
+  // CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static uint8_t putBytes(uint8_t* frame, uint8_t length, const void* value, uint8_t size) {
+  // Both AVR and the host are little-endian, which is the wire order
+  memcpy(frame + length, value, size);
+  return length + size;
+}
+
+static bool fitsInt16(int32_t value) {
+  return value >= -32768 && value <= 32767;
+}
+
+static bool writeCobs(const uint8_t* data, uint8_t length) {
+  // Consistent Overhead Byte Stuffing: replaces every 0x00 with the distance
+  // to the next one, so 0x00 only ever appears as the frame delimiter
+  uint8_t encoded[MAX_FRAME_SIZE + MAX_FRAME_SIZE / 254 + 2];
+  uint8_t codeIndex = 0;
+  uint8_t out = 1;
+  uint8_t code = 1;
+  for (uint8_t i = 0; i < length; i++) {
+    if (data[i] == 0) {
+      encoded[codeIndex] = code;
+      codeIndex = out++;
+      code = 1;
+    } else {
+      encoded[out++] = data[i];
+      code++;
+    }
+  }
+  encoded[codeIndex] = code;
+
+  if (Serial.availableForWrite() < out + 2) return false;
+  Serial.write((uint8_t)0);
+  Serial.write(encoded, out);
+  Serial.write((uint8_t)0);
+  return true;
+}
+
+static void sendFrame(uint8_t fields) {
+  bool keyframe = keyframeDue;
+  int32_t latitudeOffset = latitude - sentLatitude;
+  int32_t longitudeOffset = longitude - sentLongitude;
+  uint8_t wireFields = fields;
+  if (!keyframe && (fields & FIELD_LOCATION) && fitsInt16(latitudeOffset) && fitsInt16(longitudeOffset)) {
+    // Small move: offsets from the last sent location (±32 mdeg, ~3.6 km)
+    wireFields = (fields & ~FIELD_LOCATION) | FIELD_LOCATION_DELTA;
+  }
+
+  uint8_t frame[MAX_FRAME_SIZE];
+  uint8_t length = 0;
+  frame[length++] = keyframe ? FRAME_TYPE_KEYFRAME : FRAME_TYPE_DELTA;
+  frame[length++] = frameSequence;
+  frame[length++] = wireFields;
+  if (wireFields & FIELD_STATE) frame[length++] = stateBits;
+  if (wireFields & FIELD_SPEED) length = putBytes(frame, length, &speed, sizeof(speed));
+  if (wireFields & FIELD_LOCATION) {
+    length = putBytes(frame, length, &latitude, sizeof(latitude));
+    length = putBytes(frame, length, &longitude, sizeof(longitude));
+  }
+  if (wireFields & FIELD_TTFF) length = putBytes(frame, length, &timeToFirstFix, sizeof(timeToFirstFix));
+  if (wireFields & FIELD_LOCATION_DELTA) {
+    int16_t offsets[2] = {(int16_t)latitudeOffset, (int16_t)longitudeOffset};
+    length = putBytes(frame, length, offsets, sizeof(offsets));
+  }
+  uint16_t crc = crc16(frame, length);
+  length = putBytes(frame, length, &crc, sizeof(crc));
+
+  // The whole frame or nothing: if the TX buffer is too full it goes next tick
+  if (!writeCobs(frame, length)) return;
+  frameSequence++;
+  if (fields & FIELD_STATE) sentStateBits = stateBits;
+  if (fields & FIELD_SPEED) sentSpeed = speed;
+  if (fields & FIELD_LOCATION) {
+    sentLatitude = latitude;
+    sentLongitude = longitude;
+  }
+  if (fields & FIELD_TTFF) sentTimeToFirstFix = timeToFirstFix;
+  forcedFields = 0;
+  forcedStateBits = 0;
+  keyframeDue = false;
+}
+
+// ---------------------------------------------------------------------------
+
+static void scheduleKeyframe() {
+  // Besides the interval, the ESP32 asks for a keyframe after it resets or
+  // sees a sequence gap (requestTelemetryKeyframe(), from the command reader)
+  if (millis() - lastKeyframeTime >= TELEMETRY_KEYFRAME_INTERVAL_MS) keyframeRequested = true;
+
+  // Start the next keyframe once the previous one is out
+  if (forcedFields == 0 && forcedStateBits == 0) keyframeDue = false;
+  if (keyframeRequested && !keyframeDue) {
+    keyframeRequested = false;
+    keyframeDue = true;
+    forcedFields = publishedFields;
+    forcedStateBits = ALL_STATE_BITS;
+    lastKeyframeTime = millis();
+  }
+}
+
+void flushTelemetry() {
+  scheduleKeyframe();
+
+  // Never block and never cut into a log line that is being written
+  uint8_t fields = pendingFields();
+  if (fields == 0 || isLogLineOpen()) return;
+  if (telemetryFormat == TELEMETRY_FRAMES) {
+    sendFrame(fields);
+  } else {
+    sendText(fields);
+  }
+}
+
+bool isTelemetryPending() {
+  return pendingFields() != 0;
+}
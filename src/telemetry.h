@@ -0,0 +1,60 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// State telemetry for the ESP32 link.
+// Modules publish typed values as they change. Telemetry keeps a snapshot of
+// what the ESP32 was last sent, and flushTelemetry() (once per scheduler
+// tick) sends only the fields that differ from it, either as KEY:VALUE text
+// lines (readable, the historical format) or as a single binary frame.
+// A keyframe carrying every published field goes out at boot, every
+// TELEMETRY_KEYFRAME_INTERVAL_MS, and whenever the ESP32 sends
+// TELEMETRY_KEYFRAME_REQUEST (after a reset or a sequence gap).
+// It never blocks: what does not fit in the TX buffer is sent on a later
+// tick, merged with anything published meanwhile.
+//
+// Binary frame, COBS encoded and delimited by 0x00 on both sides (so free
+// text printed between frames is discarded by the receiver as a bad frame):
+//   type (1), sequence (1), field mask (1), fields..., CRC-16 (2)
+// Type 0x01 is a delta frame, 0x02 a keyframe; both share the sequence.
+// Fields are present in bit order of the mask, little-endian:
+//   bit 0 STATE           uint8    TELEMETRY_STATE_* bits
+//   bit 1 SPEED           uint16   km/h * 100
+//   bit 2 LOCATION        int32 x2 latitude, longitude in micro-degrees
+//   bit 3 GPS_TTFF        uint32   ms from boot to the first fix
+//   bit 4 LOCATION_DELTA  int16 x2 micro-degrees from the previous location
+//                                  (delta frames only, instead of LOCATION)
+// The CRC is CRC-16/CCITT-FALSE over type..fields.
+
+#ifndef TELEMETRY_BINARY
+#define TELEMETRY_BINARY 0  // Default format at boot: 0 = KEY:VALUE text, 1 = binary frames
+#endif
+
+enum TelemetryFormat : uint8_t { TELEMETRY_TEXT, TELEMETRY_FRAMES };
+
+// Bits of the STATE field
+const uint8_t TELEMETRY_STATE_REVERSE = 0x01;
+const uint8_t TELEMETRY_STATE_DRL = 0x02;
+const uint8_t TELEMETRY_STATE_LOW_BEAM = 0x04;
+const uint8_t TELEMETRY_STATE_HIGH_BEAM = 0x08;
+const uint8_t TELEMETRY_STATE_TAIL_LIGHT = 0x10;
+
+// Telemetry configuration
+extern const unsigned long TELEMETRY_INTERVAL_MS;           // Tick: at most one frame per interval
+extern unsigned long TELEMETRY_KEYFRAME_INTERVAL_MS;        // Full resend even without a request
+extern const char TELEMETRY_KEYFRAME_REQUEST;               // Byte the ESP32 sends to ask for a keyframe
+
+// Telemetry functions
+void setupTelemetry();
+void setTelemetryFormat(TelemetryFormat format);
+TelemetryFormat getTelemetryFormat();
+void requestTelemetryKeyframe();
+void publishState(uint8_t bit, bool on);
+void publishSpeed(uint32_t speedCentiKmh);
+void publishLocation(int32_t latitudeE6, int32_t longitudeE6);
+void publishTimeToFirstFix(uint32_t ms);
+void flushTelemetry();
+bool isTelemetryPending();
+
+#endif
@@ -0,0 +1,84 @@
+#include "timers.h"
+
+struct TimerSlot {
+  TimerCallback callback;
+  unsigned long start;
+  unsigned long delayMs;
+  bool armed;
+};
+
+static TimerSlot timerSlots[TIMER_COUNT];
+
+// Earliest deadline, as of the last change: due when millis() - nextStart >= nextDelay
+static bool timersPending = false;
+static unsigned long nextStart = 0;
+static unsigned long nextDelay = 0;
+
+static unsigned long remainingMillis(const TimerSlot& slot, unsigned long now) {
+  unsigned long elapsed = now - slot.start;
+  return elapsed >= slot.delayMs ? 0 : slot.delayMs - elapsed;
+}
+
+static void findNextDeadline() {
+  // Only runs when a slot changes, never on idle ticks
+  unsigned long now = millis();
+  timersPending = false;
+  nextStart = now;
+  nextDelay = TIMER_NONE_PENDING;
+  for (uint8_t i = 0; i < TIMER_COUNT; i++) {
+    if (!timerSlots[i].armed) continue;
+    unsigned long remaining = remainingMillis(timerSlots[i], now);
+    if (remaining < nextDelay) nextDelay = remaining;
+    timersPending = true;
+  }
+}
+
+void setupTimers() {
+  for (uint8_t i = 0; i < TIMER_COUNT; i++) {
+    timerSlots[i] = TimerSlot();
+  }
+  findNextDeadline();
+}
+
+void armTimer(uint8_t timer, unsigned long delayMs, TimerCallback callback) {
+  TimerSlot& slot = timerSlots[timer];
+  slot.callback = callback;
+  slot.start = millis();
+  slot.delayMs = delayMs;
+  slot.armed = true;
+  findNextDeadline();
+}
+
+void cancelTimer(uint8_t timer) {
+  if (!timerSlots[timer].armed) return;
+  timerSlots[timer].armed = false;
+  findNextDeadline();
+}
+
+bool isTimerArmed(uint8_t timer) {
+  const TimerSlot& slot = timerSlots[timer];
+  return slot.armed && millis() - slot.start < slot.delayMs;
+}
+
+bool isTimerDue() {
+  return timersPending && millis() - nextStart >= nextDelay;
+}
+
+void runTimers() {
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < TIMER_COUNT; i++) {
+    TimerSlot& slot = timerSlots[i];
+    if (!slot.armed || now - slot.start < slot.delayMs) continue;
+
+    // Disarmed first: the callback may arm it again
+    slot.armed = false;
+    if (slot.callback != nullptr) slot.callback();
+  }
+  findNextDeadline();
+}
+
+unsigned long millisUntilNextTimer() {
+  if (!timersPending) return TIMER_NONE_PENDING;
+  unsigned long elapsed = millis() - nextStart;
+  return elapsed >= nextDelay ? 0 : nextDelay - elapsed;
+}
@@ -0,0 +1,42 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include <Arduino.h>
+
+// Deadline service for the module timeouts.
+// Every timeout has a fixed slot. A module arms it with a delay and a
+// callback and cancels it when the condition goes away; the callback runs
+// from the "timers" scheduler task once the delay has elapsed. Deadlines are
+// kept as start + delay and compared as millis() - start >= delay, which
+// stays correct when millis() wraps around (every ~49.7 days).
+//
+// The earliest deadline is cached whenever a slot changes, so an idle tick
+// is a single compare, and millisUntilNextTimer() tells how long the
+// firmware could sleep.
+
+enum TimerId : uint8_t {
+  TIMER_HORN_MAX_DURATION,   // Horn safety cutoff
+  TIMER_CAMERA_OFF,          // Camera manual or auto-off timeout
+  TIMER_DRL_TIMEOUT,         // DRL start-up delay (cranking)
+  TIMER_DRL_CHANGE,          // Light ON/OFF debounces
+  TIMER_TAIL_LIGHT_CHANGE,
+  TIMER_BEAM_MODE_CHANGE,
+  TIMER_JOYSTICK_UP,         // Joystick debounce lockouts (no callback)
+  TIMER_JOYSTICK_DOWN,
+  TIMER_COUNT
+};
+
+typedef void (*TimerCallback)();
+
+const unsigned long TIMER_NONE_PENDING = (unsigned long)-1;
+
+// Timer functions
+void setupTimers();
+void armTimer(uint8_t timer, unsigned long delayMs, TimerCallback callback); // Restarts it if armed
+void cancelTimer(uint8_t timer);
+bool isTimerArmed(uint8_t timer);          // Armed and not yet elapsed
+bool isTimerDue();                         // Scheduler ready check: earliest deadline reached
+void runTimers();                          // Fires the elapsed timers
+unsigned long millisUntilNextTimer();      // TIMER_NONE_PENDING if nothing is armed
+
+#endif
@@ -0,0 +1,161 @@
+#include "trace.h"
+#include "adc.h"
+#include "headlights.h"
+#include "horn.h"
+#include "log.h"
+#include "reverse.h"
+
+// Trace configuration
+const char TRACE_LINE_PREFIX[] = "TRC:";
+const unsigned long TRACE_SAMPLE_INTERVAL_MS = 5;  // Same as INPUT_SAMPLE_INTERVAL_MS
+const uint8_t TRACE_ADC_MIN_CHANGE = 4;            // ~20 mV: below the filters' resolution anyway
+
+#if TRACE_RECORD
+
+static const uint8_t TRACE_LINE_MAX = 52;          // "TRC:4294967295,G,<32 hex digits>\r\n"
+static const uint8_t TRACE_CHUNK_BYTES = 16;       // Bytes per G/S line
+static const unsigned long TRACE_CHUNK_MAX_AGE_MS = 50; // Shorter GPS lines only at a sentence end or after this
+static const uint8_t TRACE_GPS_BUFFER_SIZE = 128;  // ~65 ms of 19200 baud, e.g. while a report holds the link
+static const uint8_t TRACE_SERIAL_BUFFER_SIZE = 8;
+
+// Inputs that are recorded: all on PORTD, like the debouncer's
+static const uint8_t TRACE_PINS[] = {REVERSE_GEAR_PIN, CAMERA_BUTTON_PIN, HORN_BUTTON_PIN};
+static const uint8_t TRACE_PIN_COUNT = sizeof(TRACE_PINS) / sizeof(TRACE_PINS[0]);
+
+struct TraceChannel {
+  uint8_t scanChannel;   // AdcScanChannel
+  uint8_t pin;
+};
+
+static const TraceChannel TRACE_CHANNELS[] = {
+  {ADC_SCAN_PHOTOSENSOR, PHOTOSENSOR_PIN},
+  {ADC_SCAN_JOYSTICK,    JOYSTICK_Y_PIN},
+};
+static const uint8_t TRACE_CHANNEL_COUNT = sizeof(TRACE_CHANNELS) / sizeof(TRACE_CHANNELS[0]);
+
+// Last recorded values: an input is printed again whenever it differs, so a
+// line that had to wait for the link is never lost, only late
+static uint8_t recordedPins = 0;
+static uint8_t recordedPinMask = 0;     // Pins printed at least once
+static int recordedAdc[TRACE_CHANNEL_COUNT];
+
+static uint8_t gpsBytes[TRACE_GPS_BUFFER_SIZE];
+static uint8_t gpsCount = 0;
+static unsigned long gpsTime = 0;       // millis() of the oldest buffered byte
+static unsigned long gpsLost = 0;
+static unsigned long gpsLostRecorded = 0;
+
+static uint8_t serialBytes[TRACE_SERIAL_BUFFER_SIZE];
+static uint8_t serialCount = 0;
+static unsigned long serialTime = 0;
+
+static uint8_t readTracePins() {
+#if defined(__AVR__)
+  uint8_t port = PIND;
+#else
+  uint8_t port = 0;
+  for (uint8_t i = 0; i < TRACE_PIN_COUNT; i++) {
+    if (digitalRead(TRACE_PINS[i]) == HIGH) port |= (uint8_t)(1 << TRACE_PINS[i]);
+  }
+#endif
+  return port;
+}
+
+static void printLineStart(unsigned long time, char kind) {
+  Serial.print(TRACE_LINE_PREFIX);
+  Serial.print(time);
+  Serial.print(",");
+  Serial.print(kind);
+  Serial.print(",");
+}
+
+static void printHexByte(uint8_t c) {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  Serial.print(HEX_DIGITS[c >> 4]);
+  Serial.print(HEX_DIGITS[c & 0x0F]);
+}
+
+// Prints the first bytes of a buffer as one line and shifts the rest down
+static uint8_t printChunk(char kind, unsigned long time, uint8_t* bytes, uint8_t count) {
+  uint8_t chunk = count < TRACE_CHUNK_BYTES ? count : TRACE_CHUNK_BYTES;
+  printLineStart(time, kind);
+  for (uint8_t i = 0; i < chunk; i++) {
+    printHexByte(bytes[i]);
+  }
+  Serial.println();
+  memmove(bytes, bytes + chunk, count - chunk);
+  return count - chunk;
+}
+
+static bool isGpsChunkReady(unsigned long now) {
+  // Full lines where possible: at 19200 baud a 5 ms tick only brings ~10 bytes
+  return gpsCount >= TRACE_CHUNK_BYTES || gpsBytes[gpsCount - 1] == '\n' ||
+         now - gpsTime >= TRACE_CHUNK_MAX_AGE_MS;
+}
+
+void setupTrace() {
+  recordedPinMask = 0;
+  for (uint8_t i = 0; i < TRACE_CHANNEL_COUNT; i++) {
+    recordedAdc[i] = -1;
+  }
+  gpsCount = 0;
+  gpsLost = 0;
+  gpsLostRecorded = 0;
+  serialCount = 0;
+}
+
+void recordTrace() {
+  unsigned long now = millis();
+
+  uint8_t pins = readTracePins();
+  for (uint8_t i = 0; i < TRACE_PIN_COUNT; i++) {
+    uint8_t mask = (uint8_t)(1 << TRACE_PINS[i]);
+    if ((recordedPinMask & mask) && ((pins ^ recordedPins) & mask) == 0) continue;
+    if (!canWriteDebugLine(TRACE_LINE_MAX)) return;
+    printLineStart(now, 'P');
+    Serial.print(TRACE_PINS[i]);
+    Serial.print(",");
+    Serial.println((pins & mask) ? HIGH : LOW);
+    recordedPins = (recordedPins & ~mask) | (pins & mask);
+    recordedPinMask |= mask;
+  }
+
+  for (uint8_t i = 0; i < TRACE_CHANNEL_COUNT; i++) {
+    int value = readAdcChannel(TRACE_CHANNELS[i].scanChannel);
+    if (recordedAdc[i] >= 0 && abs(value - recordedAdc[i]) < TRACE_ADC_MIN_CHANGE) continue;
+    if (!canWriteDebugLine(TRACE_LINE_MAX)) return;
+    printLineStart(now, 'A');
+    Serial.print(TRACE_CHANNELS[i].pin - A0);
+    Serial.print(",");
+    Serial.println(value);
+    recordedAdc[i] = value;
+  }
+
+  while (serialCount > 0 && canWriteDebugLine(TRACE_LINE_MAX)) {
+    serialCount = printChunk('S', serialTime, serialBytes, serialCount);
+  }
+  while (gpsCount > 0 && isGpsChunkReady(now) && canWriteDebugLine(TRACE_LINE_MAX)) {
+    gpsCount = printChunk('G', gpsTime, gpsBytes, gpsCount);
+  }
+  if (gpsLost != gpsLostRecorded && canWriteDebugLine(TRACE_LINE_MAX)) {
+    printLineStart(now, 'X');
+    Serial.println(gpsLost);
+    gpsLostRecorded = gpsLost;
+  }
+}
+
+void traceGpsByte(uint8_t c) {
+  if (gpsCount == TRACE_GPS_BUFFER_SIZE) {
+    gpsLost++;
+    return;
+  }
+  if (gpsCount == 0) gpsTime = millis();
+  gpsBytes[gpsCount++] = c;
+}
+
+void traceSerialByte(uint8_t c) {
+  if (serialCount == TRACE_SERIAL_BUFFER_SIZE) return;
+  if (serialCount == 0) serialTime = millis();
+  serialBytes[serialCount++] = c;
+}
+#endif
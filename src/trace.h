@@ -0,0 +1,34 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+// Input trace recorder: 1 = the firmware also prints its raw inputs over the
+// ESP32 link, so a drive can be captured on the car and replayed on the host
+// (native build, --replay), 0 = compiled out.
+// One line per event, after the TRACE_LINE_PREFIX (other serial lines are
+// ignored by the replayer, so a plain serial log is a trace):
+//   TRC:<ms>,P,<pin>,<level>      Digital input level (reverse gear, buttons)
+//   TRC:<ms>,A,<channel>,<value>  ADC result, 0-1023 (A0 = channel 0)
+//   TRC:<ms>,G,<hex bytes>        Raw bytes from the GPS receiver
+//   TRC:<ms>,S,<hex bytes>        Bytes from the ESP32 (keyframe requests)
+//   TRC:<ms>,X,<count>            GPS bytes lost so far because the link was busy
+// Written synthetically, the same lines work without the prefix.
+#ifndef TRACE_RECORD
+#define TRACE_RECORD 0
+#endif
+
+// Trace configuration
+extern const char TRACE_LINE_PREFIX[];
+extern const unsigned long TRACE_SAMPLE_INTERVAL_MS;  // Pins and ADC are sampled like the input debouncer
+extern const uint8_t TRACE_ADC_MIN_CHANGE;            // Smaller ADC changes are not recorded
+
+#if TRACE_RECORD
+// Trace functions
+void setupTrace();
+void recordTrace();                 // Scheduler task: samples inputs, prints pending lines
+void traceGpsByte(uint8_t c);       // Every byte the GPS parser reads
+void traceSerialByte(uint8_t c);    // Every byte read from the ESP32
+#endif
+
+#endif
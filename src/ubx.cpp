@@ -0,0 +1,80 @@
+#include "ubx.h"
+#include "gps_uart.h"
+
+static const uint8_t UBX_SYNC_1 = 0xB5;
+static const uint8_t UBX_SYNC_2 = 0x62;
+
+// Write one byte and fold it into the running Fletcher checksum
+static void writeChecksummed(uint8_t c, uint8_t& ckA, uint8_t& ckB) {
+  gpsUartWrite(c);
+  ckA += c;
+  ckB += ckA;
+}
+
+void ubxSend(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length) {
+  uint8_t ckA = 0;
+  uint8_t ckB = 0;
+
+  gpsUartWrite(UBX_SYNC_1);
+  gpsUartWrite(UBX_SYNC_2);
+  writeChecksummed(msgClass, ckA, ckB);
+  writeChecksummed(msgId, ckA, ckB);
+  writeChecksummed(length & 0xFF, ckA, ckB);
+  writeChecksummed(length >> 8, ckA, ckB);
+  for (uint16_t i = 0; i < length; i++) {
+    writeChecksummed(payload[i], ckA, ckB);
+  }
+  gpsUartWrite(ckA);
+  gpsUartWrite(ckB);
+}
+
+UbxAckResult ubxWaitAck(uint8_t msgClass, uint8_t msgId, unsigned long timeoutMs) {
+  // Scan the receive stream for an ACK frame; NMEA text in between is skipped
+  // (the receiver keeps streaming while it is being configured).
+  uint8_t frame[8];  // class, id, length (2), payload (2), checksum (2)
+  uint8_t position = 0;
+  bool synced = false;
+  uint8_t previous = 0;
+  unsigned long start = millis();
+
+  while (millis() - start < timeoutMs) {
+    if (gpsUartAvailable() <= 0) {
+      delay(1);
+      continue;
+    }
+    uint8_t c = (uint8_t)gpsUartRead();
+
+    if (!synced) {
+      synced = (previous == UBX_SYNC_1 && c == UBX_SYNC_2);
+      previous = c;
+      position = 0;
+      continue;
+    }
+
+    frame[position++] = c;
+    if (position == 4 && (frame[0] != UBX_CLASS_ACK || frame[2] != 2 || frame[3] != 0)) {
+      synced = false;  // Not an ACK frame: resynchronise on the next header
+      previous = 0;
+      continue;
+    }
+    if (position < sizeof(frame)) continue;
+
+    synced = false;
+    previous = 0;
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    for (uint8_t i = 0; i < 6; i++) {
+      ckA += frame[i];
+      ckB += ckA;
+    }
+    if (ckA != frame[6] || ckB != frame[7]) continue;
+    if (frame[4] != msgClass || frame[5] != msgId) continue;
+    return frame[1] == UBX_ACK_ACK ? UBX_ACKED : UBX_NAKED;
+  }
+  return UBX_NO_REPLY;
+}
+
+UbxAckResult ubxSendConfig(uint8_t msgId, const uint8_t* payload, uint16_t length, unsigned long timeoutMs) {
+  ubxSend(UBX_CLASS_CFG, msgId, payload, length);
+  return ubxWaitAck(UBX_CLASS_CFG, msgId, timeoutMs);
+}
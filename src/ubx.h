@@ -0,0 +1,30 @@
+#ifndef UBX_H
+#define UBX_H
+
+#include <Arduino.h>
+
+// u-blox UBX binary protocol over the GPS UART, used to configure the
+// receiver at boot. Frames are B5 62, class, id, little-endian length,
+// payload and an 8-bit Fletcher checksum. CFG messages are answered with
+// ACK-ACK or ACK-NAK carrying the class/id of the acknowledged message.
+
+// UBX message classes and IDs used by the firmware
+const uint8_t UBX_CLASS_NMEA = 0xF0;
+const uint8_t UBX_CLASS_ACK = 0x05;
+const uint8_t UBX_CLASS_CFG = 0x06;
+const uint8_t UBX_CLASS_AID = 0x0B;
+const uint8_t UBX_ACK_NAK = 0x00;
+const uint8_t UBX_ACK_ACK = 0x01;
+const uint8_t UBX_CFG_PRT = 0x00;
+const uint8_t UBX_CFG_MSG = 0x01;
+const uint8_t UBX_CFG_RATE = 0x08;
+const uint8_t UBX_AID_INI = 0x01;
+
+enum UbxAckResult : uint8_t { UBX_ACKED, UBX_NAKED, UBX_NO_REPLY };
+
+// UBX functions
+void ubxSend(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length);
+UbxAckResult ubxWaitAck(uint8_t msgClass, uint8_t msgId, unsigned long timeoutMs);
+UbxAckResult ubxSendConfig(uint8_t msgId, const uint8_t* payload, uint16_t length, unsigned long timeoutMs);
+
+#endif
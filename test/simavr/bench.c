@@ -0,0 +1,364 @@
+// Benchmark harness: runs the nanoatmega328 firmware ELF in simavr and
+// measures it cycle-exactly while a fixed script drives the inputs.
+//
+// Stimuli (see SCRIPT below):
+//   - touch edges on D6 (horn) and D5 (camera button), reverse gear on D3
+//   - ADC ramps on A0 (photosensor, tunnel entry) and A1 (joystick up)
+//   - an RMC sentence per second at 9600 baud on D8 (GPS RX, ICP1), 20 knots
+//     so the car counts as moving
+//
+// Results, one per line, in the firmware's KEY:VALUE style:
+//   BENCH:<metric>,<value>
+//   - latency.<name>_us: stimulus to the relay pin going LOW (active low)
+//   - loop.{min,mean,max}_cycles: entry to entry of the symbol given with --loop
+//   - isr.<name>.{mean,max}_cycles: vector entry to reti, per --isr symbol
+//   - setup_us: reset to the first loop pass
+// A latency that never happens is reported as "timeout".
+//
+// Symbol addresses come from the ELF (run_bench.py looks them up with
+// avr-nm), so the harness needs no debug info:
+//   bench firmware.elf [--loop ADDR] [--isr NAME=ADDR]... [--echo]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/avr_adc.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/sim_elf.h>
+
+#define F_CPU 16000000UL
+#define GPS_BAUD 9600
+#define MAX_ISRS 12
+
+#define MS(ms) ((avr_cycle_count_t)(ms) * (F_CPU / 1000))
+
+enum step_kind { STEP_PIN, STEP_ADC_RAMP };
+
+struct step {
+  uint32_t at_ms;
+  enum step_kind kind;
+  char port;             // STEP_PIN only
+  uint8_t bit;           // STEP_PIN: port bit, STEP_ADC_RAMP: ADC channel
+  uint16_t level;        // STEP_PIN: 0/1, STEP_ADC_RAMP: target millivolts
+  uint16_t ramp_ms;      // STEP_ADC_RAMP: time to reach the target
+  const char *metric;    // Latency from this step to the watched pin, or NULL
+  char watch_port;
+  uint8_t watch_bit;
+};
+
+// Boot takes ~1.5 s (GPS configuration attempts time out without a receiver
+// that answers UBX); everything starts after it. The tunnel waits for the
+// passing flash to finish (it also switches D13), and the camera button is only
+// pressed once the reverse-gear camera has timed out (30 s).
+static const struct step SCRIPT[] = {
+  {2000,  STEP_PIN,      'D', 6, 1,    0,  "touch_to_horn",          'B', 4},  // D6 -> D12
+  {2300,  STEP_PIN,      'D', 6, 0,    0,  NULL,                     0,   0},
+  {3000,  STEP_PIN,      'D', 3, 0,    0,  "reverse_to_camera",      'D', 4},  // D3 -> D4
+  {3500,  STEP_PIN,      'D', 3, 1,    0,  NULL,                     0,   0},
+  {4000,  STEP_ADC_RAMP, 0,   1, 4500, 20, "joystick_to_high_beam",  'C', 2},  // A1 -> A2
+  {4300,  STEP_ADC_RAMP, 0,   1, 2500, 20, NULL,                     0,   0},
+  {8000,  STEP_ADC_RAMP, 0,   0, 3500, 10, "tunnel_to_low_beam",     'B', 5},  // A0 -> D13
+  {35000, STEP_PIN,      'D', 5, 1,    0,  "button_to_camera",       'D', 4},  // D5 -> D4
+  {35300, STEP_PIN,      'D', 5, 0,    0,  NULL,                     0,   0},
+};
+#define SCRIPT_STEPS (sizeof(SCRIPT) / sizeof(SCRIPT[0]))
+#define SCRIPT_END_MS 36000
+
+struct latency {
+  avr_cycle_count_t start;
+  avr_cycle_count_t elapsed;
+  int pending;
+  int done;
+};
+
+struct ramp {
+  uint8_t channel;
+  uint32_t from_mv;
+  uint32_t to_mv;
+  avr_cycle_count_t start;
+  avr_cycle_count_t length;
+};
+
+struct isr_probe {
+  const char *name;
+  avr_flashaddr_t addr;
+  uint16_t entry_sp;
+  avr_cycle_count_t entry;
+  int active;
+  unsigned long count;
+  avr_cycle_count_t total;
+  avr_cycle_count_t max;
+};
+
+static avr_t *avr;
+static struct latency latencies[SCRIPT_STEPS];
+static struct ramp ramps[2];
+static uint32_t adc_mv[2] = {1000, 2500};   // Daylight, joystick centred
+static int echo_serial;
+
+static avr_flashaddr_t loop_addr;
+static avr_cycle_count_t loop_last, loop_min = (avr_cycle_count_t)-1, loop_max, loop_total;
+static unsigned long loop_count;
+static avr_cycle_count_t first_loop;
+
+static struct isr_probe isrs[MAX_ISRS];
+static int isr_count;
+
+static char gps_sentence[96];
+static size_t gps_pos;
+static unsigned gps_seconds;
+static avr_cycle_count_t gps_sentence_start;
+static avr_cycle_count_t gps_byte_start;
+static int gps_bit;
+
+static void set_pin(char port, uint8_t bit, uint32_t level) {
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit), level);
+}
+
+static void set_adc(uint8_t channel, uint32_t mv) {
+  adc_mv[channel] = mv;
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + channel), mv);
+}
+
+// --- Outputs ---------------------------------------------------------------
+
+static void on_output_pin(struct avr_irq_t *irq, uint32_t value, void *param) {
+  size_t i = (size_t)param;
+  (void)irq;
+  if (!latencies[i].pending || value != 0) return;
+  latencies[i].pending = 0;
+  latencies[i].done = 1;
+  latencies[i].elapsed = avr->cycle - latencies[i].start;
+}
+
+static void on_serial_byte(struct avr_irq_t *irq, uint32_t value, void *param) {
+  (void)irq;
+  (void)param;
+  if (echo_serial) fputc((int)value, stderr);
+}
+
+// --- Inputs ----------------------------------------------------------------
+
+static avr_cycle_count_t run_ramp(avr_t *a, avr_cycle_count_t when, void *param) {
+  struct ramp *r = param;
+  avr_cycle_count_t done = when - r->start;
+  if (done >= r->length) {
+    set_adc(r->channel, r->to_mv);
+    return 0;
+  }
+  int64_t span = (int64_t)r->to_mv - (int64_t)r->from_mv;
+  set_adc(r->channel, (uint32_t)((int64_t)r->from_mv + span * (int64_t)done / (int64_t)r->length));
+  (void)a;
+  return when + MS(1);
+}
+
+static avr_cycle_count_t run_step(avr_t *a, avr_cycle_count_t when, void *param) {
+  size_t i = (size_t)param;
+  const struct step *s = &SCRIPT[i];
+
+  if (s->metric != NULL) {
+    latencies[i].start = when;
+    latencies[i].pending = 1;
+  }
+  if (s->kind == STEP_PIN) {
+    set_pin(s->port, s->bit, s->level);
+  } else {
+    struct ramp *r = &ramps[s->bit];
+    r->channel = s->bit;
+    r->from_mv = adc_mv[s->bit];
+    r->to_mv = s->level;
+    r->start = when;
+    r->length = MS(s->ramp_ms);
+    avr_cycle_timer_register(a, 1, run_ramp, r);
+  }
+  return 0;
+}
+
+// GPS: one RMC sentence per second, bit-banged onto PB0 (8N1, idle high).
+// Bit edges are placed from the start of each byte, so the baud rate
+// carries no rounding drift.
+static void next_gps_sentence(void) {
+  unsigned s = gps_seconds++;
+  char body[80];
+  snprintf(body, sizeof(body), "GPRMC,12%02u%02u.00,A,4807.038,N,01131.000,E,20.0,084.4,230394,003.1,W",
+           (s / 60) % 60, s % 60);
+  uint8_t checksum = 0;
+  for (const char *c = body; *c; c++) checksum ^= (uint8_t)*c;
+  snprintf(gps_sentence, sizeof(gps_sentence), "$%s*%02X\r\n", body, checksum);
+  gps_pos = 0;
+}
+
+static avr_cycle_count_t run_gps(avr_t *a, avr_cycle_count_t when, void *param) {
+  (void)a;
+  (void)param;
+  if (gps_bit == 0) {
+    gps_byte_start = when;
+    if (gps_pos == 0) gps_sentence_start = when;
+  }
+
+  uint8_t c = (uint8_t)gps_sentence[gps_pos];
+  uint32_t level = gps_bit == 0 ? 0 : (gps_bit <= 8 ? (c >> (gps_bit - 1)) & 1 : 1);
+  set_pin('B', 0, level);
+
+  if (++gps_bit <= 9) {
+    return gps_byte_start + (avr_cycle_count_t)gps_bit * F_CPU / GPS_BAUD;
+  }
+  gps_bit = 0;
+  if (gps_sentence[++gps_pos] != '\0') {
+    return gps_byte_start + 10 * F_CPU / GPS_BAUD;
+  }
+  next_gps_sentence();
+  return gps_sentence_start + MS(1000);
+}
+
+// --- Code probes -----------------------------------------------------------
+
+static uint16_t stack_pointer(void) {
+  return (uint16_t)(avr->data[R_SPL] | (avr->data[R_SPH] << 8));
+}
+
+static void probe(void) {
+  avr_flashaddr_t pc = avr->pc;
+
+  if (pc == loop_addr && loop_addr != 0) {
+    if (loop_count == 0 && first_loop == 0) {
+      first_loop = avr->cycle;
+    } else {
+      avr_cycle_count_t pass = avr->cycle - loop_last;
+      if (pass < loop_min) loop_min = pass;
+      if (pass > loop_max) loop_max = pass;
+      loop_total += pass;
+      loop_count++;
+    }
+    loop_last = avr->cycle;
+  }
+
+  for (int i = 0; i < isr_count; i++) {
+    struct isr_probe *p = &isrs[i];
+    if (!p->active && pc == p->addr) {
+      // The return address is on the stack; reti pops it
+      p->active = 1;
+      p->entry = avr->cycle;
+      p->entry_sp = stack_pointer();
+    } else if (p->active && stack_pointer() > p->entry_sp) {
+      avr_cycle_count_t cycles = avr->cycle - p->entry;
+      p->active = 0;
+      p->count++;
+      p->total += cycles;
+      if (cycles > p->max) p->max = cycles;
+    }
+  }
+}
+
+// --- Main ------------------------------------------------------------------
+
+static void usage(void) {
+  fprintf(stderr, "usage: bench firmware.elf [--loop ADDR] [--isr NAME=ADDR]... [--echo]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *elf = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--loop") == 0 && i + 1 < argc) {
+      loop_addr = (avr_flashaddr_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--isr") == 0 && i + 1 < argc && isr_count < MAX_ISRS) {
+      char *spec = argv[++i];
+      char *eq = strchr(spec, '=');
+      if (eq == NULL) usage();
+      *eq = '\0';
+      isrs[isr_count].name = spec;
+      isrs[isr_count].addr = (avr_flashaddr_t)strtoul(eq + 1, NULL, 0);
+      isr_count++;
+    } else if (strcmp(argv[i], "--echo") == 0) {
+      echo_serial = 1;
+    } else if (argv[i][0] != '-' && elf == NULL) {
+      elf = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if (elf == NULL) usage();
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(elf, &firmware) != 0) {
+    fprintf(stderr, "bench: cannot read %s\n", elf);
+    return 2;
+  }
+  avr = avr_make_mcu_by_name("atmega328p");
+  if (avr == NULL) {
+    fprintf(stderr, "bench: simavr has no atmega328p core\n");
+    return 2;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+  avr->frequency = F_CPU;   // The Arduino ELF carries no .mmcu section
+  avr->vcc = avr->avcc = avr->aref = 5000;
+
+  // Serial to the ESP32: keep it off stdout, which carries the results
+  uint32_t flags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                          on_serial_byte, NULL);
+
+  // Idle inputs: reverse switch open (pull-up), buttons untouched, GPS line idle
+  set_pin('D', 3, 1);
+  set_pin('D', 5, 0);
+  set_pin('D', 6, 0);
+  set_pin('B', 0, 1);
+  set_adc(0, adc_mv[0]);
+  set_adc(1, adc_mv[1]);
+
+  for (size_t i = 0; i < SCRIPT_STEPS; i++) {
+    const struct step *s = &SCRIPT[i];
+    if (s->metric != NULL) {
+      avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(s->watch_port), s->watch_bit),
+                              on_output_pin, (void *)i);
+    }
+    avr_cycle_timer_register(avr, MS(s->at_ms), run_step, (void *)i);
+  }
+  next_gps_sentence();
+  avr_cycle_timer_register(avr, MS(500), run_gps, NULL);
+
+  avr_cycle_count_t end = MS(SCRIPT_END_MS);
+  while (avr->cycle < end) {
+    int state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      fprintf(stderr, "bench: firmware stopped at pc 0x%x, cycle %" PRIu64 "\n",
+              (unsigned)avr->pc, (uint64_t)avr->cycle);
+      return 2;
+    }
+    probe();
+  }
+
+  for (size_t i = 0; i < SCRIPT_STEPS; i++) {
+    if (SCRIPT[i].metric == NULL) continue;
+    if (latencies[i].done) {
+      printf("BENCH:latency.%s_us,%" PRIu64 "\n", SCRIPT[i].metric,
+             (uint64_t)(latencies[i].elapsed / (F_CPU / 1000000)));
+    } else {
+      printf("BENCH:latency.%s_us,timeout\n", SCRIPT[i].metric);
+    }
+  }
+  if (loop_addr != 0 && loop_count > 0) {
+    printf("BENCH:setup_us,%" PRIu64 "\n", (uint64_t)(first_loop / (F_CPU / 1000000)));
+    printf("BENCH:loop.min_cycles,%" PRIu64 "\n", (uint64_t)loop_min);
+    printf("BENCH:loop.mean_cycles,%" PRIu64 "\n", (uint64_t)(loop_total / loop_count));
+    printf("BENCH:loop.max_cycles,%" PRIu64 "\n", (uint64_t)loop_max);
+  }
+  for (int i = 0; i < isr_count; i++) {
+    if (isrs[i].count == 0) continue;
+    printf("BENCH:isr.%s.mean_cycles,%" PRIu64 "\n", isrs[i].name, (uint64_t)(isrs[i].total / isrs[i].count));
+    printf("BENCH:isr.%s.max_cycles,%" PRIu64 "\n", isrs[i].name, (uint64_t)isrs[i].max);
+  }
+  printf("BENCH_DONE\n");
+  return 0;
+}
@@ -0,0 +1,15 @@
+# PlatformIO extra script: adds the simavr benchmark as a target of the
+# nanoatmega328 environment, so a regression fails the command.
+#   pio run -e nanoatmega328 -t bench
+# It stays a manual target until baselines.txt holds values recorded from a
+# real simavr run; only then can it become a post-link check like the RAM
+# budget.
+Import("env")
+
+env.AddCustomTarget(
+    name="bench",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions='"$PYTHONEXE" test/simavr/run_bench.py --elf "$BUILD_DIR/${PROGNAME}.elf"',
+    title="Benchmark",
+    description="Run the firmware under simavr and compare with test/simavr/baselines.txt",
+)
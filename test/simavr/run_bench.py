@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""Runs the simavr benchmark against the nanoatmega328 firmware and compares
+the results with the checked-in baselines.
+
+    python3 test/simavr/run_bench.py [--elf ELF] [--update] [--echo]
+
+Builds the harness (bench.c, needs simavr and libelf), looks up the loop
+and interrupt handler addresses with avr-nm, runs the scripted scenario and
+checks every BENCH: result against baselines.txt. All metrics are
+lower-is-better; a result above its baseline by more than the tolerance, a
+latency that timed out, a baselined metric that went missing or a metric
+with no baseline recorded fails the run (exit 1). --update rewrites the
+baseline values from this run and keeps the tolerances.
+
+Also available as a PlatformIO target: pio run -e nanoatmega328 -t bench
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+DEFAULT_ELF = os.path.join(ROOT, ".pio", "build", "nanoatmega328", "firmware.elf")
+BASELINES = os.path.join(HERE, "baselines.txt")
+BUILD_DIR = os.path.join(ROOT, ".pio", "simavr")
+DEFAULT_TOLERANCE = 5.0  # Percent
+
+# One loop pass: loop() itself, or the scheduler if LTO folded loop() into main()
+LOOP_SYMBOLS = ["loop", "_Z4loopv", "_Z12runSchedulerv"]
+
+# ATmega328P vectors used by the firmware (Arduino core included)
+ISR_SYMBOLS = {
+    "int1_reverse": "__vector_2",
+    "pcint2_horn": "__vector_5",
+    "timer2_sequence": "__vector_7",
+    "timer1_capt_gps_rx": "__vector_10",
+    "timer1_compa_gps_tx": "__vector_11",
+    "timer1_compb_gps_rx": "__vector_12",
+    "timer0_millis": "__vector_16",
+    "usart_udre": "__vector_19",
+    "adc": "__vector_21",
+}
+
+
+class Unavailable(Exception):
+    """simavr, libelf, a C compiler or avr-nm is missing."""
+
+
+def find_tool(name):
+    path = shutil.which(name)
+    if path:
+        return path
+    toolchain = os.path.expanduser(os.path.join("~", ".platformio", "packages", "toolchain-atmelavr", "bin", name))
+    return toolchain if os.path.exists(toolchain) else None
+
+
+def build_harness():
+    os.makedirs(BUILD_DIR, exist_ok=True)
+    binary = os.path.join(BUILD_DIR, "bench")
+    source = os.path.join(HERE, "bench.c")
+    if os.path.exists(binary) and os.path.getmtime(binary) >= os.path.getmtime(source):
+        return binary
+
+    flags = ["-lsimavr", "-lelf"]
+    try:
+        flags = subprocess.run(["pkg-config", "--cflags", "--libs", "simavr"], check=True,
+                               capture_output=True, text=True).stdout.split() + ["-lelf"]
+    except (OSError, subprocess.CalledProcessError):
+        pass
+    compiler = os.environ.get("CC", "cc")
+    # A missing simavr is "unavailable"; an error in bench.c itself fails
+    probe = os.path.join(BUILD_DIR, "probe.c")
+    with open(probe, "w") as f:
+        f.write("#include <simavr/sim_avr.h>\nint main(void) { return avr_make_mcu_by_name(\"atmega328p\") == 0; }\n")
+    try:
+        subprocess.run([compiler, "-o", os.path.join(BUILD_DIR, "probe"), probe] + flags, check=True,
+                       capture_output=True)
+    except (OSError, subprocess.CalledProcessError):
+        raise Unavailable("simavr, libelf or a C compiler not found")
+    subprocess.run([compiler, "-O2", "-Wall", "-o", binary, source] + flags, check=True)
+    return binary
+
+
+def read_symbols(elf):
+    nm = find_tool("avr-nm")
+    if nm is None:
+        raise Unavailable("avr-nm not found (install the PlatformIO atmelavr toolchain)")
+    symbols = {}
+    output = subprocess.run([nm, elf], check=True, capture_output=True, text=True).stdout
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in "Tt":
+            symbols.setdefault(parts[2], int(parts[0], 16))
+    return symbols
+
+
+def read_baselines():
+    # <metric> <value|-> [tolerance %]; "-" = not recorded yet
+    baselines = {}
+    header = []
+    if not os.path.exists(BASELINES):
+        return baselines, header
+    with open(BASELINES) as f:
+        for line in f:
+            stripped = line.strip()
+            if not stripped or stripped.startswith("#"):
+                if not baselines:
+                    header.append(line.rstrip("\n"))
+                continue
+            parts = stripped.split()
+            value = None if parts[1] == "-" else int(parts[1])
+            tolerance = float(parts[2]) if len(parts) > 2 else DEFAULT_TOLERANCE
+            baselines[parts[0]] = (value, tolerance)
+    return baselines, header
+
+
+def write_baselines(header, baselines, results):
+    metrics = list(baselines) + [m for m in results if m not in baselines]
+    width = max(len(m) for m in metrics)
+    with open(BASELINES, "w") as f:
+        for line in header:
+            f.write(line + "\n")
+        for metric in metrics:
+            value, tolerance = baselines.get(metric, (None, DEFAULT_TOLERANCE))
+            value = results.get(metric, value)
+            shown = "-" if value is None else str(value)
+            f.write("%-*s %10s %6g\n" % (width, metric, shown, tolerance))
+
+
+def run_harness(binary, elf, symbols, echo):
+    args = [binary, elf]
+    loop = next((symbols[s] for s in LOOP_SYMBOLS if s in symbols), None)
+    if loop is not None:
+        args += ["--loop", hex(loop)]
+    for name, symbol in ISR_SYMBOLS.items():
+        if symbol in symbols:
+            args += ["--isr", "%s=%s" % (name, hex(symbols[symbol]))]
+    if echo:
+        args.append("--echo")
+
+    output = subprocess.run(args, check=True, stdout=subprocess.PIPE, text=True).stdout
+    results = {}
+    for line in output.splitlines():
+        if line.startswith("BENCH:"):
+            metric, value = line[len("BENCH:"):].rsplit(",", 1)
+            results[metric] = None if value == "timeout" else int(value)
+    if "BENCH_DONE" not in output:
+        sys.exit("bench: harness did not finish")
+    return results
+
+
+def compare(baselines, results):
+    failed = False
+    for metric in list(baselines) + [m for m in results if m not in baselines]:
+        baseline, tolerance = baselines.get(metric, (None, DEFAULT_TOLERANCE))
+        if metric not in results:
+            status = "MISSING" if baseline is not None else "SKIPPED"
+            failed |= baseline is not None
+            print("%-40s %10s %10s  %s" % (metric, "-", baseline if baseline is not None else "-", status))
+            continue
+        value = results[metric]
+        if value is None:
+            status = "TIMEOUT"
+            failed = True
+        elif baseline is None:
+            # Nothing to compare with: a check that cannot fail is no check
+            status = "NO BASELINE (run with --update)"
+            failed = True
+        elif value > baseline * (1 + tolerance / 100.0):
+            status = "REGRESSED"
+            failed = True
+        elif value < baseline * (1 - tolerance / 100.0):
+            status = "IMPROVED (run with --update)"
+        else:
+            status = "ok"
+        shown = "timeout" if value is None else value
+        print("%-40s %10s %10s  %s" % (metric, shown, baseline if baseline is not None else "-", status))
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--elf", default=DEFAULT_ELF)
+    parser.add_argument("--update", action="store_true", help="record this run as the new baselines")
+    parser.add_argument("--echo", action="store_true", help="copy the firmware's serial output to stderr")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.elf):
+        sys.exit("bench: %s not found (pio run -e nanoatmega328)" % args.elf)
+
+    try:
+        binary = build_harness()
+        symbols = read_symbols(args.elf)
+    except Unavailable as e:
+        sys.exit("bench: %s" % e)
+
+    results = run_harness(binary, args.elf, symbols, args.echo)
+    baselines, header = read_baselines()
+    if args.update:
+        write_baselines(header, baselines, {m: v for m, v in results.items() if v is not None})
+        baselines, header = read_baselines()
+    failed = compare(baselines, results)
+    if failed and not args.update:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Static RAM budget for the nanoatmega328 firmware.
+
+    python3 tools/ram_budget.py [--elf ELF] [--ram BYTES] [--headroom BYTES]
+
+Breaks .data + .bss down by module (gps.cpp, headlights.cpp, ..., the Arduino
+core and libraries) from the ELF's symbol table and fails (exit 1) when the
+RAM left for the heap and the stack is below the headroom. The stack's real
+depth is only known at run time: the firmware's MEM: report (send 'M') gives
+its high-water mark, which is what the headroom should be tuned against.
+A headroom of 0 (the default) only reports, and fails only when static data
+alone overflows the RAM.
+
+Runs after every nanoatmega328 build via tools/ram_budget_target.py; the
+headroom comes from custom_ram_headroom in platformio.ini.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SRC_DIR = os.path.join(ROOT, "src")
+DEFAULT_ELF = os.path.join(ROOT, ".pio", "build", "nanoatmega328", "firmware.elf")
+DEFAULT_RAM = 2048       # ATmega328P
+DEFAULT_HEADROOM = 0     # Report only until a headroom is measured on hardware
+
+# Data space addresses in the ELF are offset by 0x800000; EEPROM starts at 0x810000
+RAM_BASE = 0x800000
+RAM_LIMIT = 0x810000
+
+STATIC_SECTIONS = (".data", ".bss", ".noinit")
+UNATTRIBUTED = "(unnamed: literals, padding)"
+
+
+def run_tool(tool, args):
+    try:
+        return subprocess.run([tool] + args, check=True, stdout=subprocess.PIPE,
+                              universal_newlines=True).stdout
+    except OSError as error:
+        sys.exit("ram_budget: cannot run %s: %s" % (tool, error))
+
+
+def section_sizes(elf, size_tool):
+    # avr-size -A: "<section> <size> <addr>" per line
+    sizes = {}
+    for line in run_tool(size_tool, ["-A", elf]).splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0] in STATIC_SECTIONS:
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def source_definitions():
+    # File-scope and function-local variables of the project, by name: the
+    # fallback when the ELF has no debug info to locate a symbol
+    definitions = {}
+    pattern = re.compile(r"^\s*(?:static\s+|volatile\s+|const\s+)*[A-Za-z_][\w:<>]*[\s\*]+"
+                         r"([A-Za-z_]\w*)\s*(?:\[[^\]]*\]\s*)*(?:=|;|\{)")
+    for name in sorted(os.listdir(SRC_DIR)):
+        if not name.endswith(".cpp"):
+            continue
+        with open(os.path.join(SRC_DIR, name)) as source:
+            for line in source:
+                match = pattern.match(line)
+                if match and not line.lstrip().startswith("return"):
+                    definitions.setdefault(match.group(1), set()).add(name)
+    return definitions
+
+
+def module_of_path(path):
+    path = os.path.normpath(path)
+    if path.startswith(SRC_DIR + os.sep):
+        return os.path.relpath(path, SRC_DIR)
+    parts = path.split(os.sep)
+    if "libdeps" in parts:
+        index = parts.index("libdeps")
+        if index + 2 < len(parts):
+            return "lib " + parts[index + 2]
+    return "core " + os.path.basename(path)
+
+
+def module_of_name(name, definitions):
+    # "printHexByte(unsigned char)::HEX_DIGITS", "rxBuffer.lto_priv.0"
+    base = name.split("::")[-1].split(".")[0]
+    files = definitions.get(base, ())
+    if len(files) == 1:
+        return next(iter(files))
+    return None
+
+
+def symbols_by_module(elf, nm_tool):
+    definitions = source_definitions()
+    modules = {}
+    output = run_tool(nm_tool, ["-S", "-l", "-C", "--defined-only", elf])
+    for line in output.splitlines():
+        # "00800123 00000002 b name<TAB>/path/file.cpp:12"
+        symbol, _, location = line.partition("\t")
+        fields = symbol.split(None, 3)
+        if len(fields) != 4 or fields[2] not in "bBdD":
+            continue
+        address, size, kind, name = int(fields[0], 16), int(fields[1], 16), fields[2], fields[3]
+        if not RAM_BASE <= address < RAM_LIMIT:
+            continue
+        module = None
+        if location:
+            module = module_of_path(location.rsplit(":", 1)[0])
+        if module is None or module.startswith("core "):
+            module = module_of_name(name, definitions) or module
+        if module is None:
+            module = "(unknown) " + name
+        entry = modules.setdefault(module, [0, 0])
+        entry[0 if kind in "dD" else 1] += size
+    return modules
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Static RAM budget per module")
+    parser.add_argument("--elf", default=DEFAULT_ELF)
+    parser.add_argument("--ram", type=int, default=DEFAULT_RAM, help="SRAM size in bytes")
+    parser.add_argument("--headroom", type=int, default=DEFAULT_HEADROOM,
+                        help="bytes that must stay free for the heap and the stack")
+    parser.add_argument("--nm", default="avr-nm")
+    parser.add_argument("--size", default="avr-size")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.elf):
+        sys.exit("ram_budget: %s not found, build the nanoatmega328 env first" % args.elf)
+
+    sections = section_sizes(args.elf, args.size)
+    modules = symbols_by_module(args.elf, args.nm)
+    static_bytes = sum(sections.values())
+    data_total = sections.get(".data", 0)
+    bss_total = sections.get(".bss", 0) + sections.get(".noinit", 0)
+    data_named = sum(entry[0] for entry in modules.values())
+    bss_named = sum(entry[1] for entry in modules.values())
+    if data_total > data_named or bss_total > bss_named:
+        modules[UNATTRIBUTED] = [max(data_total - data_named, 0), max(bss_total - bss_named, 0)]
+
+    print("RAM budget: %s" % os.path.relpath(args.elf, ROOT))
+    print("  %-32s %6s %6s %6s" % ("module", "data", "bss", "total"))
+    for module, (data, bss) in sorted(modules.items(), key=lambda item: -sum(item[1])):
+        print("  %-32s %6d %6d %6d" % (module, data, bss, data + bss))
+    free = args.ram - static_bytes
+    print("  %-32s %6d %6d %6d  (%.1f%% of %d)" % ("static total", data_total, bss_total,
+                                                 static_bytes, 100.0 * static_bytes / args.ram, args.ram))
+    if args.headroom > 0:
+        print("  left for heap and stack: %d bytes, headroom required: %d" % (free, args.headroom))
+    else:
+        print("  left for heap and stack: %d bytes (no headroom set, report only)" % free)
+
+    if free < 0:
+        print("ram_budget: FAIL, static data is %d bytes over the RAM size" % -free)
+        return 1
+    if free < args.headroom:
+        print("ram_budget: FAIL, %d bytes short of the headroom" % (args.headroom - free))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,17 @@
+# PlatformIO extra script: prints the static RAM budget after every link of
+# the nanoatmega328 environment. Once custom_ram_headroom is set, a module
+# that eats into the stack's headroom fails the build; without it (or at 0)
+# the budget is only reported.
+Import("env")
+
+headroom = env.GetProjectOption("custom_ram_headroom", "0")
+ram = env.BoardConfig().get("upload.maximum_ram_size", 2048)
+
+env.AddPostAction(
+    "$BUILD_DIR/${PROGNAME}.elf",
+    env.VerboseAction(
+        '"$PYTHONEXE" tools/ram_budget.py --elf "$BUILD_DIR/${PROGNAME}.elf" '
+        "--ram %s --headroom %s" % (ram, headroom),
+        "Checking RAM budget",
+    ),
+)